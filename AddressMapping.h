@@ -31,7 +31,8 @@
 #define ADDRESS_MAPPING_H
 namespace DRAMSim
 {
-	void addressMapping(uint64_t physicalAddress, unsigned &channel, unsigned &rank, unsigned &bank, unsigned &row, unsigned &col);
+	struct Config;
+	void addressMapping(const Config &config, uint64_t physicalAddress, unsigned &channel, unsigned &rank, unsigned &bank, unsigned &row, unsigned &col);
 }
 
 #endif
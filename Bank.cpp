@@ -39,9 +39,9 @@
 using namespace std;
 using namespace DRAMSim;
 
-Bank::Bank(ostream &dramsim_log_):
-		currentState(dramsim_log_), 
-		rowEntries(NUM_COLS),
+Bank::Bank(const Config &config_, ostream &dramsim_log_):
+		config(config_),
+		rowEntries(config_.NUM_COLS),
 		dramsim_log(dramsim_log_)
 {}
 
@@ -88,7 +88,7 @@ void Bank::read(BusPacket *busPacket)
 	{
 		// the row hasn't been written before, so it isn't in the list
 		//if(SHOW_SIM_OUTPUT) DEBUG("== Warning - Read from previously unwritten row " << busPacket->row);
-		void *garbage = calloc(BL * (JEDEC_DATA_BUS_BITS/8),1);
+		void *garbage = calloc(config.BL * (config.JEDEC_DATA_BUS_BITS/8),1);
 		((long *)garbage)[0] = 0xdeadbeef; // tracer value
 		busPacket->data = garbage;
 	}
@@ -107,7 +107,7 @@ void Bank::write(const BusPacket *busPacket)
 	//TODO: move all the error checking to BusPacket so once we have a bus packet,
 	//			we know the fields are all legal
 
-	if (busPacket->column >= NUM_COLS)
+	if (busPacket->column >= config.NUM_COLS)
 	{
 		ERROR("== Error - Bus Packet column "<< busPacket->column <<" out of bounds");
 		exit(-1);
@@ -133,10 +133,10 @@ void Bank::write(const BusPacket *busPacket)
 	{
 		// found it, just plaster in the new data
 		foundNode->data = busPacket->data;
-		if (DEBUG_BANKS)
+		if (config.DEBUG_BANKS)
 		{
 			PRINTN(" -- Bank "<<busPacket->bank<<" writing to physical address 0x" << hex << busPacket->physicalAddress<<dec<<":");
-			busPacket->printData();
+			busPacket->printData(dramsim_log);
 			PRINT("");
 		}
 	}
@@ -41,48 +41,173 @@
 //
 
 #include "BankState.h"
+#include <algorithm>
 
 using namespace std;
 using namespace DRAMSim;
 
 //All banks start precharged
-BankState::BankState(ostream &dramsim_log_):
-		dramsim_log(dramsim_log_),
+BankState::BankState():
+		nextPowerUp(0),
+		nextStateChange(0),
+		activatedAt(0),
 		currentBankState(Idle),
 		openRowAddress(0),
-		nextRead(0),
-		nextWrite(0),
-		nextActivate(0),
-		nextPrecharge(0),
-		nextPowerUp(0),
-		lastCommand(READ),
-		stateChangeCountdown(0)
+		lastCommand(READ)
+{}
+
+BankStateTable::LastColumnCommand::LastColumnCommand():
+		cycle(0),
+		otherCycle(0),
+		rank(0),
+		valid(false),
+		otherValid(false)
 {}
 
-void BankState::print()
+void BankStateTable::LastColumnCommand::record(unsigned rank_, uint64_t cycle_)
+{
+	if (valid && rank != rank_)
+	{
+		otherCycle = cycle;
+		otherValid = true;
+	}
+	cycle = cycle_;
+	rank = rank_;
+	valid = true;
+}
+
+bool BankStateTable::LastColumnCommand::fromOtherRank(unsigned rank_, uint64_t &cycle_) const
+{
+	if (valid && rank != rank_)
+	{
+		cycle_ = cycle;
+		return true;
+	}
+	if (otherValid)
+	{
+		cycle_ = otherCycle;
+		return true;
+	}
+	return false;
+}
+
+BankStateTable::BankStateTable(const Config &config_, unsigned numRanks):
+		config(config_),
+		numBanks(config_.NUM_BANKS),
+		states(numRanks*config_.NUM_BANKS),
+		nextReads(numRanks*config_.NUM_BANKS, 0),
+		nextWrites(numRanks*config_.NUM_BANKS, 0),
+		nextActivates(numRanks*config_.NUM_BANKS, 0),
+		nextPrecharges(numRanks*config_.NUM_BANKS, 0),
+		rankNextReads(numRanks, 0),
+		rankNextWrites(numRanks, 0)
+{}
+
+//reads and writes on other ranks only hold up banks that were active when
+//they were issued, i.e. the ones issued since the bank's row was opened
+uint64_t BankStateTable::otherRankNextRead(unsigned rank, uint64_t since) const
+{
+	uint64_t cycle, next = 0;
+	if (lastRead.fromOtherRank(rank, cycle) && cycle >= since)
+	{
+		next = cycle + config.BL/2 + config.tRTRS;
+	}
+	if (lastWrite.fromOtherRank(rank, cycle) && cycle >= since)
+	{
+		next = max(next, cycle + config.WRITE_TO_READ_DELAY_R());
+	}
+	return next;
+}
+
+uint64_t BankStateTable::otherRankNextWrite(unsigned rank, uint64_t since) const
+{
+	uint64_t cycle, next = 0;
+	if (lastRead.fromOtherRank(rank, cycle) && cycle >= since)
+	{
+		next = cycle + config.READ_TO_WRITE_DELAY();
+	}
+	if (lastWrite.fromOtherRank(rank, cycle) && cycle >= since)
+	{
+		next = max(next, cycle + config.BL/2 + config.tRTRS);
+	}
+	return next;
+}
+
+uint64_t BankStateTable::earliestRead(unsigned rank, unsigned bank) const
+{
+	unsigned i = rank*numBanks + bank;
+	uint64_t earliest = max(nextReads[i], rankNextReads[rank]);
+	if (states[i].currentBankState == RowActive)
+	{
+		earliest = max(earliest, otherRankNextRead(rank, states[i].activatedAt));
+	}
+	return earliest;
+}
+
+uint64_t BankStateTable::earliestWrite(unsigned rank, unsigned bank) const
+{
+	unsigned i = rank*numBanks + bank;
+	uint64_t earliest = max(nextWrites[i], rankNextWrites[rank]);
+	if (states[i].currentBankState == RowActive)
+	{
+		earliest = max(earliest, otherRankNextWrite(rank, states[i].activatedAt));
+	}
+	return earliest;
+}
+
+void BankStateTable::readIssued(unsigned rank, uint64_t cycle)
+{
+	rankNextReads[rank] = max(rankNextReads[rank], cycle + max(config.tCCD, config.BL/2));
+	rankNextWrites[rank] = max(rankNextWrites[rank], cycle + config.READ_TO_WRITE_DELAY());
+	lastRead.record(rank, cycle);
+}
+
+void BankStateTable::writeIssued(unsigned rank, uint64_t cycle)
+{
+	rankNextWrites[rank] = max(rankNextWrites[rank], cycle + max(config.BL/2, config.tCCD));
+	rankNextReads[rank] = max(rankNextReads[rank], cycle + config.WRITE_TO_READ_DELAY_B());
+	lastWrite.record(rank, cycle);
+}
+
+void BankStateTable::rowOpened(unsigned rank, unsigned bank, uint64_t cycle)
+{
+	states[rank*numBanks + bank].activatedAt = cycle;
+}
+
+//once the row is closed the other ranks' commands no longer apply, so the
+//ones that did while it was open are kept with the bank
+void BankStateTable::rowClosed(unsigned rank, unsigned bank)
+{
+	unsigned i = rank*numBanks + bank;
+	nextReads[i] = max(nextReads[i], otherRankNextRead(rank, states[i].activatedAt));
+	nextWrites[i] = max(nextWrites[i], otherRankNextWrite(rank, states[i].activatedAt));
+}
+
+void BankStateTable::print(unsigned rank, unsigned bank, ostream &dramsim_log)
 {
+	const BankState &bankState = state(rank, bank);
 	PRINT(" == Bank State ");
-	if (currentBankState == Idle)
+	if (bankState.currentBankState == Idle)
 	{
 		PRINT("    State : Idle" );
 	}
-	else if (currentBankState == RowActive)
+	else if (bankState.currentBankState == RowActive)
 	{
 		PRINT("    State : Active" );
 	}
-	else if (currentBankState == Refreshing)
+	else if (bankState.currentBankState == Refreshing)
 	{
 		PRINT("    State : Refreshing" );
 	}
-	else if (currentBankState == PowerDown)
+	else if (bankState.currentBankState == PowerDown)
 	{
 		PRINT("    State : Power Down" );
 	}
 
-	PRINT("    OpenRowAddress : " << openRowAddress );
-	PRINT("    nextRead       : " << nextRead );
-	PRINT("    nextWrite      : " << nextWrite );
-	PRINT("    nextActivate   : " << nextActivate );
-	PRINT("    nextPrecharge  : " << nextPrecharge );
-	PRINT("    nextPowerUp    : " << nextPowerUp );
+	PRINT("    OpenRowAddress : " << bankState.openRowAddress );
+	PRINT("    nextRead       : " << earliestRead(rank, bank) );
+	PRINT("    nextWrite      : " << earliestWrite(rank, bank) );
+	PRINT("    nextActivate   : " << nextActivate(rank, bank) );
+	PRINT("    nextPrecharge  : " << nextPrecharge(rank, bank) );
+	PRINT("    nextPowerUp    : " << bankState.nextPowerUp );
 }
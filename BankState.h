@@ -45,6 +45,9 @@
 
 #include "SystemConfiguration.h"
 #include "BusPacket.h"
+#include <vector>
+
+using std::vector;
 
 namespace DRAMSim
 {
@@ -57,25 +60,97 @@ enum CurrentBankState
 	PowerDown
 };
 
-class BankState
+//everything about a bank except the timing constraints the scheduler checks
+//all the time, which BankStateTable keeps separately
+struct BankState
 {
-	ostream &dramsim_log; 
-public:
 	//Fields
+	uint64_t nextPowerUp;
+	uint64_t nextStateChange; //0 if there is no implicit state change coming up
+	uint64_t activatedAt; //when the open row was activated
 	CurrentBankState currentBankState;
 	unsigned openRowAddress;
-	uint64_t nextRead;
-	uint64_t nextWrite;
-	uint64_t nextActivate;
-	uint64_t nextPrecharge;
-	uint64_t nextPowerUp;
-
 	BusPacketType lastCommand;
-	unsigned stateChangeCountdown;
 
 	//Functions
-	BankState(ostream &dramsim_log_);
-	void print();
+	BankState();
+};
+
+//the state of every bank of a channel (or of a single rank). nextRead,
+//nextWrite, nextActivate and nextPrecharge are each kept in one flat array
+//indexed by rank*NUM_BANKS+bank, so issuability checks and the loops that
+//update every bank only touch the fields they need.
+//
+//A read or write delays the column commands of every bank on the channel.
+//Rather than pushing that out to each bank, the table keeps the constraint
+//on the issuing rank's banks per rank, and the latest read and write on the
+//channel for the constraint on the other ranks' banks. earliestRead() and
+//earliestWrite() combine them with the bank's own values.
+class BankStateTable
+{
+	//the latest read or write, and the latest one from a different rank
+	struct LastColumnCommand
+	{
+		uint64_t cycle;
+		uint64_t otherCycle;
+		unsigned rank;
+		bool valid;
+		bool otherValid;
+
+		LastColumnCommand();
+		void record(unsigned rank_, uint64_t cycle_);
+		//the latest one from any rank but rank_, false if there is none
+		bool fromOtherRank(unsigned rank_, uint64_t &cycle_) const;
+	};
+
+	const Config &config;
+	unsigned numBanks;
+	vector<BankState> states;
+	vector<uint64_t> nextReads;
+	vector<uint64_t> nextWrites;
+	vector<uint64_t> nextActivates;
+	vector<uint64_t> nextPrecharges;
+	vector<uint64_t> rankNextReads;
+	vector<uint64_t> rankNextWrites;
+	LastColumnCommand lastRead;
+	LastColumnCommand lastWrite;
+
+	uint64_t otherRankNextRead(unsigned rank, uint64_t since) const;
+	uint64_t otherRankNextWrite(unsigned rank, uint64_t since) const;
+public:
+	BankStateTable(const Config &config_, unsigned numRanks);
+
+	BankState &state(unsigned rank, unsigned bank)
+	{
+		return states[rank*numBanks + bank];
+	}
+	//nextRead and nextWrite only hold constraints that are specific to the
+	//bank, such as tRCD; use earliestRead() and earliestWrite() to check them
+	uint64_t &nextRead(unsigned rank, unsigned bank)
+	{
+		return nextReads[rank*numBanks + bank];
+	}
+	uint64_t &nextWrite(unsigned rank, unsigned bank)
+	{
+		return nextWrites[rank*numBanks + bank];
+	}
+	uint64_t &nextActivate(unsigned rank, unsigned bank)
+	{
+		return nextActivates[rank*numBanks + bank];
+	}
+	uint64_t &nextPrecharge(unsigned rank, unsigned bank)
+	{
+		return nextPrecharges[rank*numBanks + bank];
+	}
+	uint64_t earliestRead(unsigned rank, unsigned bank) const;
+	uint64_t earliestWrite(unsigned rank, unsigned bank) const;
+
+	void readIssued(unsigned rank, uint64_t cycle);
+	void writeIssued(unsigned rank, uint64_t cycle);
+	void rowOpened(unsigned rank, unsigned bank, uint64_t cycle);
+	void rowClosed(unsigned rank, unsigned bank);
+
+	void print(unsigned rank, unsigned bank, ostream &dramsim_log);
 };
 }
 
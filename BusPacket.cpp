@@ -46,16 +46,14 @@ using namespace DRAMSim;
 using namespace std;
 
 BusPacket::BusPacket(BusPacketType packtype, uint64_t physicalAddr, 
-		unsigned col, unsigned rw, unsigned r, unsigned b, void *dat, 
-		ostream &dramsim_log_) :
-	dramsim_log(dramsim_log_),
+		unsigned col, unsigned rw, unsigned r, unsigned b, void *dat) :
+	physicalAddress(physicalAddr),
+	data(dat),
 	busPacketType(packtype),
 	column(col),
 	row(rw),
 	bank(b),
-	rank(r),
-	physicalAddress(physicalAddr),
-	data(dat)
+	rank(r)
 {}
 
 void BusPacket::print(uint64_t currentClockCycle, bool dataStart)
@@ -65,41 +63,39 @@ void BusPacket::print(uint64_t currentClockCycle, bool dataStart)
 		return;
 	}
 
-	if (VERIFICATION_OUTPUT)
+	//only called when VERIFICATION_OUTPUT is set
+	switch (busPacketType)
 	{
-		switch (busPacketType)
-		{
-		case READ:
-			cmd_verify_out << currentClockCycle << ": read ("<<rank<<","<<bank<<","<<column<<",0);"<<endl;
-			break;
-		case READ_P:
-			cmd_verify_out << currentClockCycle << ": read ("<<rank<<","<<bank<<","<<column<<",1);"<<endl;
-			break;
-		case WRITE:
-			cmd_verify_out << currentClockCycle << ": write ("<<rank<<","<<bank<<","<<column<<",0 , 0, 'h0);"<<endl;
-			break;
-		case WRITE_P:
-			cmd_verify_out << currentClockCycle << ": write ("<<rank<<","<<bank<<","<<column<<",1, 0, 'h0);"<<endl;
-			break;
-		case ACTIVATE:
-			cmd_verify_out << currentClockCycle <<": activate (" << rank << "," << bank << "," << row <<");"<<endl;
-			break;
-		case PRECHARGE:
-			cmd_verify_out << currentClockCycle <<": precharge (" << rank << "," << bank << "," << row <<");"<<endl;
-			break;
-		case REFRESH:
-			cmd_verify_out << currentClockCycle <<": refresh (" << rank << ");"<<endl;
-			break;
-		case DATA:
-			//TODO: data verification?
-			break;
-		default:
-			ERROR("Trying to print unknown kind of bus packet");
-			exit(-1);
-		}
+	case READ:
+		cmd_verify_out << currentClockCycle << ": read ("<<rank<<","<<bank<<","<<column<<",0);"<<endl;
+		break;
+	case READ_P:
+		cmd_verify_out << currentClockCycle << ": read ("<<rank<<","<<bank<<","<<column<<",1);"<<endl;
+		break;
+	case WRITE:
+		cmd_verify_out << currentClockCycle << ": write ("<<rank<<","<<bank<<","<<column<<",0 , 0, 'h0);"<<endl;
+		break;
+	case WRITE_P:
+		cmd_verify_out << currentClockCycle << ": write ("<<rank<<","<<bank<<","<<column<<",1, 0, 'h0);"<<endl;
+		break;
+	case ACTIVATE:
+		cmd_verify_out << currentClockCycle <<": activate (" << rank << "," << bank << "," << row <<");"<<endl;
+		break;
+	case PRECHARGE:
+		cmd_verify_out << currentClockCycle <<": precharge (" << rank << "," << bank << "," << row <<");"<<endl;
+		break;
+	case REFRESH:
+		cmd_verify_out << currentClockCycle <<": refresh (" << rank << ");"<<endl;
+		break;
+	case DATA:
+		//TODO: data verification?
+		break;
+	default:
+		ERROR("Trying to print unknown kind of bus packet");
+		exit(-1);
 	}
 }
-void BusPacket::print()
+void BusPacket::print(ostream &dramsim_log)
 {
 	if (this == NULL) //pointer use makes this a necessary precaution
 	{
@@ -132,7 +128,7 @@ void BusPacket::print()
 			break;
 		case DATA:
 			PRINTN("BP [DATA] pa[0x"<<hex<<physicalAddress<<dec<<"] r["<<rank<<"] b["<<bank<<"] row["<<row<<"] col["<<column<<"] data["<<data<<"]=");
-			printData();
+			printData(dramsim_log);
 			PRINT("");
 			break;
 		default:
@@ -142,7 +138,7 @@ void BusPacket::print()
 	}
 }
 
-void BusPacket::printData() const 
+void BusPacket::printData(ostream &dramsim_log) const 
 {
 	if (data == NULL)
 	{
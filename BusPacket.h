@@ -36,6 +36,7 @@
 //
 
 #include "SystemConfiguration.h"
+#include "ObjectPool.h"
 
 namespace DRAMSim
 {
@@ -51,26 +52,45 @@ enum BusPacketType
 	DATA
 };
 
+//plain data, so the print functions take the log of whoever owns the packet
 class BusPacket
 {
 	BusPacket();
-	ostream &dramsim_log; 
 public:
 	//Fields
+	uint64_t physicalAddress;
+	void *data;
 	BusPacketType busPacketType;
 	unsigned column;
 	unsigned row;
 	unsigned bank;
 	unsigned rank;
-	uint64_t physicalAddress;
-	void *data;
 
 	//Functions
-	BusPacket(BusPacketType packtype, uint64_t physicalAddr, unsigned col, unsigned rw, unsigned r, unsigned b, void *dat, ostream &dramsim_log_);
+	BusPacket(BusPacketType packtype, uint64_t physicalAddr, unsigned col, unsigned rw, unsigned r, unsigned b, void *dat);
 
-	void print();
+	void print(ostream &dramsim_log);
 	void print(uint64_t currentClockCycle, bool dataStart);
-	void printData() const;
+	void printData(ostream &dramsim_log) const;
+
+	//several of these are created and destroyed for every request
+	static void *operator new(size_t size)
+	{
+		return ObjectPool<BusPacket>::allocate(size);
+	}
+	//the memory system counts the ones it creates itself in its stats
+	static void *operator new(size_t size, PoolStats &stats)
+	{
+		return ObjectPool<BusPacket>::allocate(size, &stats);
+	}
+	static void operator delete(void *p)
+	{
+		ObjectPool<BusPacket>::release(p);
+	}
+	static void operator delete(void *p, PoolStats &)
+	{
+		ObjectPool<BusPacket>::release(p);
+	}
 
 };
 }
@@ -46,8 +46,16 @@
 
 using namespace DRAMSim;
 
-CommandQueue::CommandQueue(vector< vector<BankState> > &states, ostream &dramsim_log_) :
+static bool isColumnAccess(const BusPacket *packet)
+{
+	return packet->busPacketType == READ || packet->busPacketType == READ_P ||
+		packet->busPacketType == WRITE || packet->busPacketType == WRITE_P;
+}
+
+CommandQueue::CommandQueue(BankStateTable &states, const Config &config_, ostream &dramsim_log_, PoolStats &busPacketAllocations_) :
+		config(config_),
 		dramsim_log(dramsim_log_),
+		busPacketAllocations(busPacketAllocations_),
 		bankStates(states),
 		nextBank(0),
 		nextRank(0),
@@ -55,6 +63,8 @@ CommandQueue::CommandQueue(vector< vector<BankState> > &states, ostream &dramsim
 		nextRankPRE(0),
 		refreshRank(0),
 		refreshWaiting(false),
+		pagePredictions(0),
+		correctPagePredictions(0),
 		sendAct(true)
 {
 	//set here to avoid compile errors
@@ -62,13 +72,13 @@ CommandQueue::CommandQueue(vector< vector<BankState> > &states, ostream &dramsim
 
 	//use numBankQueus below to create queue structure
 	size_t numBankQueues;
-	if (queuingStructure==PerRank)
+	if (config.queuingStructure==PerRank)
 	{
 		numBankQueues = 1;
 	}
-	else if (queuingStructure==PerRankPerBank)
+	else if (config.queuingStructure==PerRankPerBank)
 	{
-		numBankQueues = NUM_BANKS;
+		numBankQueues = config.NUM_BANKS;
 	}
 	else
 	{
@@ -77,13 +87,17 @@ CommandQueue::CommandQueue(vector< vector<BankState> > &states, ostream &dramsim
 	}
 
 	//vector of counters used to ensure rows don't stay open too long
-	rowAccessCounters = vector< vector<unsigned> >(NUM_RANKS, vector<unsigned>(NUM_BANKS,0));
+	rowAccessCounters = vector< vector<unsigned> >(config.NUM_RANKS, vector<unsigned>(config.NUM_BANKS,0));
+
+	//every bank starts out leaning towards closing idle rows, like open_page does
+	PagePredictor predictor = {1, false, false, 0, 0};
+	pagePredictors = vector< vector<PagePredictor> >(config.NUM_RANKS, vector<PagePredictor>(config.NUM_BANKS, predictor));
 
 	//create queue based on the structure we want
 	BusPacket1D actualQueue;
 	BusPacket2D perBankQueue = BusPacket2D();
 	queues = BusPacket3D();
-	for (size_t rank=0; rank<NUM_RANKS; rank++)
+	for (size_t rank=0; rank<config.NUM_RANKS; rank++)
 	{
 		//this loop will run only once for per-rank and NUM_BANKS times for per-rank-per-bank
 		for (size_t bank=0; bank<numBankQueues; bank++)
@@ -96,26 +110,73 @@ CommandQueue::CommandQueue(vector< vector<BankState> > &states, ostream &dramsim
 
 
 	//FOUR-bank activation window
-	//	this will count the number of activations within a given window
-	//	(decrementing counter)
-	//
-	//countdown vector will have decrementing counters starting at tFAW
-	//  when the 0th element reaches 0, remove it
-	tFAWCountdown.reserve(NUM_RANKS);
-	for (size_t i=0;i<NUM_RANKS;i++)
+	//	each rank remembers when its last four activates were issued
+	tFAWWindows = vector<RollingWindow>(config.NUM_RANKS, RollingWindow(4, config.tFAW));
+
+	//packet counts per rank, so isEmpty() doesn't have to look at every bank queue
+	rankOccupancy = vector<unsigned>(config.NUM_RANKS, 0);
+
+	//one bit per queue, set while the queue holds something; the bits are laid
+	//	out in round robin order so the scheduler can jump straight to the next
+	//	queue with work in it
+	numQueueSlots = config.NUM_RANKS * numBankQueues;
+	occupiedQueues = vector<uint64_t>((numQueueSlots + 63) / 64, 0);
+
+	//the policies can't change during a run, so pick the versions of
+	//	enqueue() and pop() built for them once here instead of re-checking
+	//	them for every packet
+	if (config.queuingStructure==PerRank)
+	{
+		if (config.rowBufferPolicy==ClosePage)
+			selectPolicies<ClosePage, PerRank>();
+		else if (config.rowBufferPolicy==AdaptivePage)
+			selectPolicies<AdaptivePage, PerRank>();
+		else
+			selectPolicies<OpenPage, PerRank>();
+	}
+	else
 	{
-		//init the empty vectors here so we don't seg fault later
-		tFAWCountdown.push_back(vector<unsigned>());
+		if (config.rowBufferPolicy==ClosePage)
+			selectPolicies<ClosePage, PerRankPerBank>();
+		else if (config.rowBufferPolicy==AdaptivePage)
+			selectPolicies<AdaptivePage, PerRankPerBank>();
+		else
+			selectPolicies<OpenPage, PerRankPerBank>();
+	}
+}
+
+template <RowBufferPolicy rowBufferPolicy, QueuingStructure queuingStructure>
+void CommandQueue::selectPolicies()
+{
+	if (config.schedulingPolicy==RankThenBankRoundRobin)
+	{
+		enqueueFunction = &CommandQueue::enqueueWith<queuingStructure, RankThenBankRoundRobin>;
+		popFunction = &CommandQueue::popWith<rowBufferPolicy, queuingStructure, RankThenBankRoundRobin>;
+	}
+	else if (config.schedulingPolicy==BankThenRankRoundRobin)
+	{
+		enqueueFunction = &CommandQueue::enqueueWith<queuingStructure, BankThenRankRoundRobin>;
+		popFunction = &CommandQueue::popWith<rowBufferPolicy, queuingStructure, BankThenRankRoundRobin>;
+	}
+	else if (config.schedulingPolicy==FRFCFS)
+	{
+		enqueueFunction = &CommandQueue::enqueueWith<queuingStructure, FRFCFS>;
+		popFunction = &CommandQueue::popWith<rowBufferPolicy, queuingStructure, FRFCFS>;
+	}
+	else
+	{
+		ERROR("== Error - Unknown scheduling policy");
+		exit(0);
 	}
 }
 CommandQueue::~CommandQueue()
 {
 	//ERROR("COMMAND QUEUE destructor");
-	size_t bankMax = NUM_RANKS;
-	if (queuingStructure == PerRank) {
+	size_t bankMax = config.NUM_RANKS;
+	if (config.queuingStructure == PerRank) {
 		bankMax = 1; 
 	}
-	for (size_t r=0; r< NUM_RANKS; r++)
+	for (size_t r=0; r< config.NUM_RANKS; r++)
 	{
 		for (size_t b=0; b<bankMax; b++) 
 		{
@@ -129,33 +190,43 @@ CommandQueue::~CommandQueue()
 }
 //Adds a command to appropriate queue
 void CommandQueue::enqueue(BusPacket *newBusPacket)
+{
+	(this->*enqueueFunction)(newBusPacket);
+}
+
+template <QueuingStructure queuingStructure, SchedulingPolicy schedulingPolicy>
+void CommandQueue::enqueueWith(BusPacket *newBusPacket)
 {
 	unsigned rank = newBusPacket->rank;
 	unsigned bank = newBusPacket->bank;
-	if (queuingStructure==PerRank)
+	vector<BusPacket *> &queue = queueFor<queuingStructure>(rank, bank);
+	if (queue.empty())
 	{
-		queues[rank][0].push_back(newBusPacket);
-		if (queues[rank][0].size()>CMD_QUEUE_DEPTH)
-		{
-			ERROR("== Error - Enqueued more than allowed in command queue");
-			ERROR("						Need to call .hasRoomFor(int numberToEnqueue, unsigned rank, unsigned bank) first");
-			exit(0);
-		}
+		unsigned slot = queueSlot<queuingStructure, schedulingPolicy>(rank, bank);
+		occupiedQueues[slot / 64] |= 1ULL << (slot % 64);
 	}
-	else if (queuingStructure==PerRankPerBank)
+	queue.push_back(newBusPacket);
+	rankOccupancy[rank]++;
+	if (queue.size()>config.CMD_QUEUE_DEPTH)
 	{
-		queues[rank][bank].push_back(newBusPacket);
-		if (queues[rank][bank].size()>CMD_QUEUE_DEPTH)
-		{
-			ERROR("== Error - Enqueued more than allowed in command queue");
-			ERROR("						Need to call .hasRoomFor(int numberToEnqueue, unsigned rank, unsigned bank) first");
-			exit(0);
-		}
+		ERROR("== Error - Enqueued more than allowed in command queue");
+		ERROR("						Need to call .hasRoomFor(int numberToEnqueue, unsigned rank, unsigned bank) first");
+		exit(0);
 	}
-	else
+}
+
+//takes count packets starting at index first out of a queue, keeping the
+//	occupancy counters and bits up to date; the caller owns the packets
+template <QueuingStructure queuingStructure, SchedulingPolicy schedulingPolicy>
+void CommandQueue::removePackets(unsigned rank, unsigned bank, size_t first, size_t count)
+{
+	vector<BusPacket *> &queue = queueFor<queuingStructure>(rank, bank);
+	queue.erase(queue.begin()+first, queue.begin()+first+count);
+	rankOccupancy[rank] -= count;
+	if (queue.empty())
 	{
-		ERROR("== Error - Unknown queuing structure");
-		exit(0);
+		unsigned slot = queueSlot<queuingStructure, schedulingPolicy>(rank, bank);
+		occupiedQueues[slot / 64] &= ~(1ULL << (slot % 64));
 	}
 }
 
@@ -163,26 +234,12 @@ void CommandQueue::enqueue(BusPacket *newBusPacket)
 //command scheduling policy
 bool CommandQueue::pop(BusPacket **busPacket)
 {
-	//this can be done here because pop() is called every clock cycle by the parent MemoryController
-	//	figures out the sliding window requirement for tFAW
-	//
-	//deal with tFAW book-keeping
-	//	each rank has it's own counter since the restriction is on a device level
-	for (size_t i=0;i<NUM_RANKS;i++)
-	{
-		//decrement all the counters we have going
-		for (size_t j=0;j<tFAWCountdown[i].size();j++)
-		{
-			tFAWCountdown[i][j]--;
-		}
-
-		//the head will always be the smallest counter, so check if it has reached 0
-		if (tFAWCountdown[i].size()>0 && tFAWCountdown[i][0]==0)
-		{
-			tFAWCountdown[i].erase(tFAWCountdown[i].begin());
-		}
-	}
+	return (this->*popFunction)(busPacket);
+}
 
+template <RowBufferPolicy rowBufferPolicy, QueuingStructure queuingStructure, SchedulingPolicy schedulingPolicy>
+bool CommandQueue::popWith(BusPacket **busPacket)
+{
 	/* Now we need to find a packet to issue. When the code picks a packet, it will set
 		 *busPacket = [some eligible packet]
 		 
@@ -199,11 +256,11 @@ bool CommandQueue::pop(BusPacket **busPacket)
 		{
 			bool foundActiveOrTooEarly = false;
 			//look for an open bank
-			for (size_t b=0;b<NUM_BANKS;b++)
+			for (size_t b=0;b<config.NUM_BANKS;b++)
 			{
-				vector<BusPacket *> &queue = getCommandQueue(refreshRank,b);
+				vector<BusPacket *> &queue = queueFor<queuingStructure>(refreshRank,b);
 				//checks to make sure that all banks are idle
-				if (bankStates[refreshRank][b].currentBankState == RowActive)
+				if (bankStates.state(refreshRank, b).currentBankState == RowActive)
 				{
 					foundActiveOrTooEarly = true;
 					//if the bank is open, make sure there is nothing else
@@ -211,13 +268,13 @@ bool CommandQueue::pop(BusPacket **busPacket)
 					for (size_t j=0;j<queue.size();j++)
 					{
 						BusPacket *packet = queue[j];
-						if (packet->row == bankStates[refreshRank][b].openRowAddress &&
+						if (packet->row == bankStates.state(refreshRank, b).openRowAddress &&
 								packet->bank == b)
 						{
 							if (packet->busPacketType != ACTIVATE && isIssuable(packet))
 							{
 								*busPacket = packet;
-								queue.erase(queue.begin() + j);
+								removePackets<queuingStructure, schedulingPolicy>(refreshRank, b, j, 1);
 								sendingREF = true;
 							}
 							break;
@@ -230,7 +287,7 @@ bool CommandQueue::pop(BusPacket **busPacket)
 				//				satisfied.	the next ACT and next REF can be issued at the same
 				//				point in the future, so just use nextActivate field instead of
 				//				creating a nextRefresh field
-				else if (bankStates[refreshRank][b].nextActivate > currentClockCycle)
+				else if (bankStates.nextActivate(refreshRank, b) > currentClockCycle)
 				{
 					foundActiveOrTooEarly = true;
 					break;
@@ -239,9 +296,9 @@ bool CommandQueue::pop(BusPacket **busPacket)
 
 			//if there are no open banks and timing has been met, send out the refresh
 			//	reset flags and rank pointer
-			if (!foundActiveOrTooEarly && bankStates[refreshRank][0].currentBankState != PowerDown)
+			if (!foundActiveOrTooEarly && bankStates.state(refreshRank, 0).currentBankState != PowerDown)
 			{
-				*busPacket = new BusPacket(REFRESH, 0, 0, 0, refreshRank, 0, 0, dramsim_log);
+				*busPacket = new (busPacketAllocations) BusPacket(REFRESH, 0, 0, 0, refreshRank, 0, 0);
 				refreshRank = -1;
 				refreshWaiting = false;
 				sendingREF = true;
@@ -249,104 +306,34 @@ bool CommandQueue::pop(BusPacket **busPacket)
 		} // refreshWaiting
 
 		//if we're not sending a REF, proceed as normal
-		if (!sendingREF)
+		//	if we couldn't find anything to send, return false
+		if (!sendingREF && !issueNextQueued<rowBufferPolicy, queuingStructure, schedulingPolicy>(busPacket))
 		{
-			bool foundIssuable = false;
-			unsigned startingRank = nextRank;
-			unsigned startingBank = nextBank;
-			do
-			{
-				vector<BusPacket *> &queue = getCommandQueue(nextRank, nextBank);
-				//make sure there is something in this queue first
-				//	also make sure a rank isn't waiting for a refresh
-				//	if a rank is waiting for a refesh, don't issue anything to it until the
-				//		refresh logic above has sent one out (ie, letting banks close)
-				if (!queue.empty() && !((nextRank == refreshRank) && refreshWaiting))
-				{
-					if (queuingStructure == PerRank)
-					{
-
-						//search from beginning to find first issuable bus packet
-						for (size_t i=0;i<queue.size();i++)
-						{
-							if (isIssuable(queue[i]))
-							{
-								//check to make sure we aren't removing a read/write that is paired with an activate
-								if (i>0 && queue[i-1]->busPacketType==ACTIVATE &&
-										queue[i-1]->physicalAddress == queue[i]->physicalAddress)
-									continue;
-
-								*busPacket = queue[i];
-								queue.erase(queue.begin()+i);
-								foundIssuable = true;
-								break;
-							}
-						}
-					}
-					else
-					{
-						if (isIssuable(queue[0]))
-						{
-
-							//no need to search because if the front can't be sent,
-							// then no chance something behind it can go instead
-							*busPacket = queue[0];
-							queue.erase(queue.begin());
-							foundIssuable = true;
-						}
-					}
-
-				}
-
-				//if we found something, break out of do-while
-				if (foundIssuable) break;
-
-				//rank round robin
-				if (queuingStructure == PerRank)
-				{
-					nextRank = (nextRank + 1) % NUM_RANKS;
-					if (startingRank == nextRank)
-					{
-						break;
-					}
-				}
-				else 
-				{
-					nextRankAndBank(nextRank, nextBank);
-					if (startingRank == nextRank && startingBank == nextBank)
-					{
-						break;
-					}
-				}
-			}
-			while (true);
-
-			//if we couldn't find anything to send, return false
-			if (!foundIssuable) return false;
+			return false;
 		}
 	}
-	else if (rowBufferPolicy==OpenPage)
+	else
 	{
 		bool sendingREForPRE = false;
 		if (refreshWaiting)
 		{
 			bool sendREF = true;
 			//make sure all banks idle and timing met for a REF
-			for (size_t b=0;b<NUM_BANKS;b++)
+			for (size_t b=0;b<config.NUM_BANKS;b++)
 			{
 				//if a bank is active we can't send a REF yet
-				if (bankStates[refreshRank][b].currentBankState == RowActive)
+				if (bankStates.state(refreshRank, b).currentBankState == RowActive)
 				{
 					sendREF = false;
 					bool closeRow = true;
 					//search for commands going to an open row
-					vector <BusPacket *> &refreshQueue = getCommandQueue(refreshRank,b);
+					vector <BusPacket *> &refreshQueue = queueFor<queuingStructure>(refreshRank,b);
 
 					for (size_t j=0;j<refreshQueue.size();j++)
 					{
 						BusPacket *packet = refreshQueue[j];
 						//if a command in the queue is going to the same row . . .
-						if (bankStates[refreshRank][b].openRowAddress == packet->row &&
+						if (bankStates.state(refreshRank, b).openRowAddress == packet->row &&
 								b == packet->bank)
 						{
 							// . . . and is not an activate . . .
@@ -358,7 +345,7 @@ bool CommandQueue::pop(BusPacket **busPacket)
 								{
 									//send it out
 									*busPacket = packet;
-									refreshQueue.erase(refreshQueue.begin()+j);
+									removePackets<queuingStructure, schedulingPolicy>(refreshRank, b, j, 1);
 									sendingREForPRE = true;
 								}
 								break;
@@ -372,10 +359,10 @@ bool CommandQueue::pop(BusPacket **busPacket)
 					}
 
 					//if the bank is open and we are allowed to close it, then send a PRE
-					if (closeRow && currentClockCycle >= bankStates[refreshRank][b].nextPrecharge)
+					if (closeRow && currentClockCycle >= bankStates.nextPrecharge(refreshRank, b))
 					{
 						rowAccessCounters[refreshRank][b]=0;
-						*busPacket = new BusPacket(PRECHARGE, 0, 0, 0, refreshRank, b, 0, dramsim_log);
+						*busPacket = new (busPacketAllocations) BusPacket(PRECHARGE, 0, 0, 0, refreshRank, b, 0);
 						sendingREForPRE = true;
 					}
 					break;
@@ -383,7 +370,7 @@ bool CommandQueue::pop(BusPacket **busPacket)
 				//	NOTE: the next ACT and next REF can be issued at the same
 				//				point in the future, so just use nextActivate field instead of
 				//				creating a nextRefresh field
-				else if (bankStates[refreshRank][b].nextActivate > currentClockCycle) //and this bank doesn't have an open row
+				else if (bankStates.nextActivate(refreshRank, b) > currentClockCycle) //and this bank doesn't have an open row
 				{
 					sendREF = false;
 					break;
@@ -392,142 +379,70 @@ bool CommandQueue::pop(BusPacket **busPacket)
 
 			//if there are no open banks and timing has been met, send out the refresh
 			//	reset flags and rank pointer
-			if (sendREF && bankStates[refreshRank][0].currentBankState != PowerDown)
+			if (sendREF && bankStates.state(refreshRank, 0).currentBankState != PowerDown)
 			{
-				*busPacket = new BusPacket(REFRESH, 0, 0, 0, refreshRank, 0, 0, dramsim_log);
+				*busPacket = new (busPacketAllocations) BusPacket(REFRESH, 0, 0, 0, refreshRank, 0, 0);
 				refreshRank = -1;
 				refreshWaiting = false;
 				sendingREForPRE = true;
 			}
 		}
 
-		if (!sendingREForPRE)
+		if (!sendingREForPRE && !issueNextQueued<rowBufferPolicy, queuingStructure, schedulingPolicy>(busPacket))
 		{
-			unsigned startingRank = nextRank;
-			unsigned startingBank = nextBank;
-			bool foundIssuable = false;
-			do // round robin over queues
-			{
-				vector<BusPacket *> &queue = getCommandQueue(nextRank,nextBank);
-				//make sure there is something there first
-				if (!queue.empty() && !((nextRank == refreshRank) && refreshWaiting))
-				{
-					//search from the beginning to find first issuable bus packet
-					for (size_t i=0;i<queue.size();i++)
-					{
-						BusPacket *packet = queue[i];
-						if (isIssuable(packet))
-						{
-							//check for dependencies
-							bool dependencyFound = false;
-							for (size_t j=0;j<i;j++)
-							{
-								BusPacket *prevPacket = queue[j];
-								if (prevPacket->busPacketType != ACTIVATE &&
-										prevPacket->bank == packet->bank &&
-										prevPacket->row == packet->row)
-								{
-									dependencyFound = true;
-									break;
-								}
-							}
-							if (dependencyFound) continue;
-
-							*busPacket = packet;
-
-							//if the bus packet before is an activate, that is the act that was
-							//	paired with the column access we are removing, so we have to remove
-							//	that activate as well (check i>0 because if i==0 then theres nothing before it)
-							if (i>0 && queue[i-1]->busPacketType == ACTIVATE)
-							{
-								rowAccessCounters[(*busPacket)->rank][(*busPacket)->bank]++;
-								// i is being returned, but i-1 is being thrown away, so must delete it here 
-								delete (queue[i-1]);
-
-								// remove both i-1 (the activate) and i (we've saved the pointer in *busPacket)
-								queue.erase(queue.begin()+i-1,queue.begin()+i+1);
-							}
-							else // there's no activate before this packet
-							{
-								//or just remove the one bus packet
-								queue.erase(queue.begin()+i);
-							}
-
-							foundIssuable = true;
-							break;
-						}
-					}
-				}
-
-				//if we found something, break out of do-while
-				if (foundIssuable) break;
-
-				//rank round robin
-				if (queuingStructure == PerRank)
-				{
-					nextRank = (nextRank + 1) % NUM_RANKS;
-					if (startingRank == nextRank)
-					{
-						break;
-					}
-				}
-				else 
-				{
-					nextRankAndBank(nextRank, nextBank); 
-					if (startingRank == nextRank && startingBank == nextBank)
-					{
-						break;
-					}
-				}
-			}
-			while (true);
-
 			//if nothing was issuable, see if we can issue a PRE to an open bank
 			//	that has no other commands waiting
-			if (!foundIssuable)
-			{
-				//search for banks to close
-				bool sendingPRE = false;
-				unsigned startingRank = nextRankPRE;
-				unsigned startingBank = nextBankPRE;
 
-				do // round robin over all ranks and banks
+			//search for banks to close
+			bool sendingPRE = false;
+			unsigned startingRank = nextRankPRE;
+			unsigned startingBank = nextBankPRE;
+
+			do // round robin over all ranks and banks
+			{
+				vector <BusPacket *> &queue = queueFor<queuingStructure>(nextRankPRE, nextBankPRE);
+				bool found = false;
+				bool bankQueued = false;
+				//check if bank is open
+				if (bankStates.state(nextRankPRE, nextBankPRE).currentBankState == RowActive)
 				{
-					vector <BusPacket *> &queue = getCommandQueue(nextRankPRE, nextBankPRE);
-					bool found = false;
-					//check if bank is open
-					if (bankStates[nextRankPRE][nextBankPRE].currentBankState == RowActive)
+					for (size_t i=0;i<queue.size();i++)
 					{
-						for (size_t i=0;i<queue.size();i++)
+						//if there is something going to that bank and row, then we don't want to send a PRE
+						if (queue[i]->bank == nextBankPRE)
 						{
-							//if there is something going to that bank and row, then we don't want to send a PRE
-							if (queue[i]->bank == nextBankPRE &&
-									queue[i]->row == bankStates[nextRankPRE][nextBankPRE].openRowAddress)
+							bankQueued = true;
+							if (queue[i]->row == bankStates.state(nextRankPRE, nextBankPRE).openRowAddress)
 							{
 								found = true;
 								break;
 							}
 						}
+					}
+
+					//adaptive page may keep a row open with nothing queued for its bank,
+					//	betting that the next access will hit it
+					bool keepOpen = rowBufferPolicy == AdaptivePage && !bankQueued &&
+						keepIdleRowOpen(nextRankPRE, nextBankPRE);
 
-						//if nothing found going to that bank and row or too many accesses have happend, close it
-						if (!found || rowAccessCounters[nextRankPRE][nextBankPRE]==TOTAL_ROW_ACCESSES)
+					//if nothing found going to that bank and row or too many accesses have happend, close it
+					if ((!found && !keepOpen) || rowAccessCounters[nextRankPRE][nextBankPRE]==config.TOTAL_ROW_ACCESSES)
+					{
+						if (currentClockCycle >= bankStates.nextPrecharge(nextRankPRE, nextBankPRE))
 						{
-							if (currentClockCycle >= bankStates[nextRankPRE][nextBankPRE].nextPrecharge)
-							{
-								sendingPRE = true;
-								rowAccessCounters[nextRankPRE][nextBankPRE] = 0;
-								*busPacket = new BusPacket(PRECHARGE, 0, 0, 0, nextRankPRE, nextBankPRE, 0, dramsim_log);
-								break;
-							}
+							sendingPRE = true;
+							rowAccessCounters[nextRankPRE][nextBankPRE] = 0;
+							*busPacket = new (busPacketAllocations) BusPacket(PRECHARGE, 0, 0, 0, nextRankPRE, nextBankPRE, 0);
+							break;
 						}
 					}
-					nextRankAndBank(nextRankPRE, nextBankPRE);
 				}
-				while (!(startingRank == nextRankPRE && startingBank == nextBankPRE));
-
-				//if no PREs could be sent, just return false
-				if (!sendingPRE) return false;
+				nextRankAndBank<schedulingPolicy>(nextRankPRE, nextBankPRE);
 			}
+			while (!(startingRank == nextRankPRE && startingBank == nextBankPRE));
+
+			//if no PREs could be sent, just return false
+			if (!sendingPRE) return false;
 		}
 	}
 
@@ -535,63 +450,260 @@ bool CommandQueue::pop(BusPacket **busPacket)
 	//  posted-cas is enabled when AL>0
 	//  when sendAct is true, when don't want to increment our indexes
 	//  so we send the column access that is paid with this act
-	if (AL>0 && sendAct)
+	if (config.AL>0 && sendAct)
 	{
 		sendAct = false;
 	}
 	else
 	{
 		sendAct = true;
-		nextRankAndBank(nextRank, nextBank);
+		nextRankAndBank<schedulingPolicy>(nextRank, nextBank);
 	}
 
-	//if its an activate, add a tfaw counter
+	//if its an activate, add it to the tfaw window
 	if ((*busPacket)->busPacketType==ACTIVATE)
 	{
-		tFAWCountdown[(*busPacket)->rank].push_back(tFAW);
+		tFAWWindows[(*busPacket)->rank].record(currentClockCycle);
+	}
+
+	if (rowBufferPolicy==AdaptivePage)
+	{
+		checkPagePrediction(*busPacket);
 	}
 
 	return true;
 }
 
+//adaptive page: called for a bank whose open row has nothing queued for it.
+//	the first time the row is seen idle the bank's counter predicts whether the
+//	next access will hit it; a row predicted to hit stays open until that access
+//	comes or it has been idle for ROW_IDLE_TIMEOUT cycles
+bool CommandQueue::keepIdleRowOpen(unsigned rank, unsigned bank)
+{
+	PagePredictor &predictor = pagePredictors[rank][bank];
+	if (!predictor.pending)
+	{
+		predictor.pending = true;
+		predictor.keepOpen = predictor.counter >= 2;
+		predictor.row = bankStates.state(rank, bank).openRowAddress;
+	}
+	if (!predictor.keepOpen)
+	{
+		return false;
+	}
+	return config.ROW_IDLE_TIMEOUT == 0 || currentClockCycle - predictor.lastAccess < config.ROW_IDLE_TIMEOUT;
+}
+
+//adaptive page: the first activate or column access to a bank after a
+//	prediction tells whether the idle row was worth keeping open
+void CommandQueue::checkPagePrediction(BusPacket *busPacket)
+{
+	if (busPacket->busPacketType != ACTIVATE && !isColumnAccess(busPacket))
+	{
+		return;
+	}
+	PagePredictor &predictor = pagePredictors[busPacket->rank][busPacket->bank];
+	if (predictor.pending)
+	{
+		bool sameRow = busPacket->row == predictor.row;
+		pagePredictions++;
+		if (sameRow == predictor.keepOpen)
+		{
+			correctPagePredictions++;
+		}
+		if (sameRow && predictor.counter < 3)
+		{
+			predictor.counter++;
+		}
+		else if (!sameRow && predictor.counter > 0)
+		{
+			predictor.counter--;
+		}
+		predictor.pending = false;
+	}
+	if (isColumnAccess(busPacket))
+	{
+		predictor.lastAccess = currentClockCycle;
+	}
+}
+
+//FR-FCFS serves column accesses to rows that are already open before anything
+//	else, so it first looks for one of those; the round robin policies just take
+//	the next packet that can go
+template <RowBufferPolicy rowBufferPolicy, QueuingStructure queuingStructure, SchedulingPolicy schedulingPolicy>
+bool CommandQueue::issueNextQueued(BusPacket **busPacket)
+{
+	if (schedulingPolicy == FRFCFS && searchQueues<rowBufferPolicy, queuingStructure, schedulingPolicy>(true, busPacket))
+	{
+		return true;
+	}
+	return searchQueues<rowBufferPolicy, queuingStructure, schedulingPolicy>(false, busPacket);
+}
+
+//round robin over the queues that have something in them, starting at the
+//	one nextRank and nextBank point to, and issue the first packet that can go.
+//	the pointers are left on the queue it came from, or unchanged if nothing
+//	could be issued
+template <RowBufferPolicy rowBufferPolicy, QueuingStructure queuingStructure, SchedulingPolicy schedulingPolicy>
+bool CommandQueue::searchQueues(bool columnAccessesOnly, BusPacket **busPacket)
+{
+	unsigned startingSlot = queueSlot<queuingStructure, schedulingPolicy>(nextRank, nextBank);
+
+	//search from the starting queue to the last one, then wrap around to it
+	for (unsigned pass=0; pass<2; pass++)
+	{
+		unsigned endSlot = (pass == 0) ? numQueueSlots : startingSlot;
+		for (unsigned slot = nextOccupiedSlot(pass == 0 ? startingSlot : 0); slot < endSlot; slot = nextOccupiedSlot(slot+1))
+		{
+			unsigned rank, bank;
+			slotRankAndBank<queuingStructure, schedulingPolicy>(slot, rank, bank);
+
+			//if a rank is waiting for a refesh, don't issue anything to it until the
+			//	refresh logic has sent one out (ie, letting banks close)
+			if (rank == refreshRank && refreshWaiting)
+			{
+				continue;
+			}
+			if (issueFromQueue<rowBufferPolicy, queuingStructure, schedulingPolicy>(rank, bank, columnAccessesOnly, busPacket))
+			{
+				nextRank = rank;
+				if (queuingStructure == PerRankPerBank)
+				{
+					nextBank = bank;
+				}
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+//tries to issue a packet from one (non-empty) queue, skipping activates and
+//	precharges if columnAccessesOnly is set
+template <RowBufferPolicy rowBufferPolicy, QueuingStructure queuingStructure, SchedulingPolicy schedulingPolicy>
+bool CommandQueue::issueFromQueue(unsigned rank, unsigned bank, bool columnAccessesOnly, BusPacket **busPacket)
+{
+	vector<BusPacket *> &queue = queueFor<queuingStructure>(rank, bank);
+
+	if (rowBufferPolicy==ClosePage)
+	{
+		if (queuingStructure == PerRank)
+		{
+			//search from beginning to find first issuable bus packet
+			for (size_t i=0;i<queue.size();i++)
+			{
+				if ((!columnAccessesOnly || isColumnAccess(queue[i])) && isIssuable(queue[i]))
+				{
+					//check to make sure we aren't removing a read/write that is paired with an activate
+					if (i>0 && queue[i-1]->busPacketType==ACTIVATE &&
+							queue[i-1]->physicalAddress == queue[i]->physicalAddress)
+						continue;
+
+					*busPacket = queue[i];
+					removePackets<queuingStructure, schedulingPolicy>(rank, bank, i, 1);
+					return true;
+				}
+			}
+		}
+		else
+		{
+			if ((!columnAccessesOnly || isColumnAccess(queue[0])) && isIssuable(queue[0]))
+			{
+				//no need to search because if the front can't be sent,
+				// then no chance something behind it can go instead
+				*busPacket = queue[0];
+				removePackets<queuingStructure, schedulingPolicy>(rank, bank, 0, 1);
+				return true;
+			}
+		}
+	}
+	else
+	{
+		//search from the beginning to find first issuable bus packet
+		for (size_t i=0;i<queue.size();i++)
+		{
+			BusPacket *packet = queue[i];
+			if ((!columnAccessesOnly || isColumnAccess(packet)) && isIssuable(packet))
+			{
+				//check for dependencies
+				bool dependencyFound = false;
+				for (size_t j=0;j<i;j++)
+				{
+					BusPacket *prevPacket = queue[j];
+					if (prevPacket->busPacketType != ACTIVATE &&
+							prevPacket->bank == packet->bank &&
+							prevPacket->row == packet->row)
+					{
+						dependencyFound = true;
+						break;
+					}
+				}
+				if (dependencyFound) continue;
+
+				*busPacket = packet;
+
+				//if the bus packet before is an activate, that is the act that was
+				//	paired with the column access we are removing, so we have to remove
+				//	that activate as well (check i>0 because if i==0 then theres nothing before it)
+				if (i>0 && queue[i-1]->busPacketType == ACTIVATE)
+				{
+					rowAccessCounters[packet->rank][packet->bank]++;
+					// i is being returned, but i-1 is being thrown away, so must delete it here 
+					delete (queue[i-1]);
+
+					// remove both i-1 (the activate) and i (we've saved the pointer in *busPacket)
+					removePackets<queuingStructure, schedulingPolicy>(rank, bank, i-1, 2);
+				}
+				else // there's no activate before this packet
+				{
+					//or just remove the one bus packet
+					removePackets<queuingStructure, schedulingPolicy>(rank, bank, i, 1);
+				}
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
 //check if a rank/bank queue has room for a certain number of bus packets
 bool CommandQueue::hasRoomFor(unsigned numberToEnqueue, unsigned rank, unsigned bank)
 {
 	vector<BusPacket *> &queue = getCommandQueue(rank, bank); 
-	return (CMD_QUEUE_DEPTH - queue.size() >= numberToEnqueue);
+	return (config.CMD_QUEUE_DEPTH - queue.size() >= numberToEnqueue);
 }
 
 //prints the contents of the command queue
 void CommandQueue::print()
 {
-	if (queuingStructure==PerRank)
+	if (config.queuingStructure==PerRank)
 	{
 		PRINT(endl << "== Printing Per Rank Queue" );
-		for (size_t i=0;i<NUM_RANKS;i++)
+		for (size_t i=0;i<config.NUM_RANKS;i++)
 		{
 			PRINT(" = Rank " << i << "  size : " << queues[i][0].size() );
 			for (size_t j=0;j<queues[i][0].size();j++)
 			{
 				PRINTN("    "<< j << "]");
-				queues[i][0][j]->print();
+				queues[i][0][j]->print(dramsim_log);
 			}
 		}
 	}
-	else if (queuingStructure==PerRankPerBank)
+	else if (config.queuingStructure==PerRankPerBank)
 	{
 		PRINT("\n== Printing Per Rank, Per Bank Queue" );
 
-		for (size_t i=0;i<NUM_RANKS;i++)
+		for (size_t i=0;i<config.NUM_RANKS;i++)
 		{
 			PRINT(" = Rank " << i );
-			for (size_t j=0;j<NUM_BANKS;j++)
+			for (size_t j=0;j<config.NUM_BANKS;j++)
 			{
 				PRINT("    Bank "<< j << "   size : " << queues[i][j].size() );
 
 				for (size_t k=0;k<queues[i][j].size();k++)
 				{
 					PRINTN("       " << k << "]");
-					queues[i][j][k]->print();
+					queues[i][j][k]->print(dramsim_log);
 				}
 			}
 		}
@@ -605,11 +717,11 @@ void CommandQueue::print()
  */
 vector<BusPacket *> &CommandQueue::getCommandQueue(unsigned rank, unsigned bank)
 {
-	if (queuingStructure == PerRankPerBank)
+	if (config.queuingStructure == PerRankPerBank)
 	{
 		return queues[rank][bank];
 	}
-	else if (queuingStructure == PerRank)
+	else if (config.queuingStructure == PerRank)
 	{
 		return queues[rank][0];
 	}
@@ -621,6 +733,19 @@ vector<BusPacket *> &CommandQueue::getCommandQueue(unsigned rank, unsigned bank)
 
 }
 
+template <QueuingStructure queuingStructure>
+vector<BusPacket *> &CommandQueue::queueFor(unsigned rank, unsigned bank)
+{
+	if (queuingStructure == PerRankPerBank)
+	{
+		return queues[rank][bank];
+	}
+	else
+	{
+		return queues[rank][0];
+	}
+}
+
 //checks if busPacket is allowed to be issued
 bool CommandQueue::isIssuable(BusPacket *busPacket)
 {
@@ -630,10 +755,10 @@ bool CommandQueue::isIssuable(BusPacket *busPacket)
 
 		break;
 	case ACTIVATE:
-		if ((bankStates[busPacket->rank][busPacket->bank].currentBankState == Idle ||
-		        bankStates[busPacket->rank][busPacket->bank].currentBankState == Refreshing) &&
-		        currentClockCycle >= bankStates[busPacket->rank][busPacket->bank].nextActivate &&
-		        tFAWCountdown[busPacket->rank].size() < 4)
+		if ((bankStates.state(busPacket->rank, busPacket->bank).currentBankState == Idle ||
+		        bankStates.state(busPacket->rank, busPacket->bank).currentBankState == Refreshing) &&
+		        currentClockCycle >= bankStates.nextActivate(busPacket->rank, busPacket->bank) &&
+		        tFAWWindows[busPacket->rank].allows(currentClockCycle))
 		{
 			return true;
 		}
@@ -644,10 +769,10 @@ bool CommandQueue::isIssuable(BusPacket *busPacket)
 		break;
 	case WRITE:
 	case WRITE_P:
-		if (bankStates[busPacket->rank][busPacket->bank].currentBankState == RowActive &&
-		        currentClockCycle >= bankStates[busPacket->rank][busPacket->bank].nextWrite &&
-		        busPacket->row == bankStates[busPacket->rank][busPacket->bank].openRowAddress &&
-		        rowAccessCounters[busPacket->rank][busPacket->bank] < TOTAL_ROW_ACCESSES)
+		if (bankStates.state(busPacket->rank, busPacket->bank).currentBankState == RowActive &&
+		        currentClockCycle >= bankStates.earliestWrite(busPacket->rank, busPacket->bank) &&
+		        busPacket->row == bankStates.state(busPacket->rank, busPacket->bank).openRowAddress &&
+		        rowAccessCounters[busPacket->rank][busPacket->bank] < config.TOTAL_ROW_ACCESSES)
 		{
 			return true;
 		}
@@ -658,10 +783,10 @@ bool CommandQueue::isIssuable(BusPacket *busPacket)
 		break;
 	case READ_P:
 	case READ:
-		if (bankStates[busPacket->rank][busPacket->bank].currentBankState == RowActive &&
-		        currentClockCycle >= bankStates[busPacket->rank][busPacket->bank].nextRead &&
-		        busPacket->row == bankStates[busPacket->rank][busPacket->bank].openRowAddress &&
-		        rowAccessCounters[busPacket->rank][busPacket->bank] < TOTAL_ROW_ACCESSES)
+		if (bankStates.state(busPacket->rank, busPacket->bank).currentBankState == RowActive &&
+		        currentClockCycle >= bankStates.earliestRead(busPacket->rank, busPacket->bank) &&
+		        busPacket->row == bankStates.state(busPacket->rank, busPacket->bank).openRowAddress &&
+		        rowAccessCounters[busPacket->rank][busPacket->bank] < config.TOTAL_ROW_ACCESSES)
 		{
 			return true;
 		}
@@ -671,8 +796,8 @@ bool CommandQueue::isIssuable(BusPacket *busPacket)
 		}
 		break;
 	case PRECHARGE:
-		if (bankStates[busPacket->rank][busPacket->bank].currentBankState == RowActive &&
-		        currentClockCycle >= bankStates[busPacket->rank][busPacket->bank].nextPrecharge)
+		if (bankStates.state(busPacket->rank, busPacket->bank).currentBankState == RowActive &&
+		        currentClockCycle >= bankStates.nextPrecharge(busPacket->rank, busPacket->bank))
 		{
 			return true;
 		}
@@ -683,7 +808,7 @@ bool CommandQueue::isIssuable(BusPacket *busPacket)
 		break;
 	default:
 		ERROR("== Error - Trying to issue a crazy bus packet type : ");
-		busPacket->print();
+		busPacket->print(dramsim_log);
 		exit(0);
 	}
 	return false;
@@ -692,23 +817,7 @@ bool CommandQueue::isIssuable(BusPacket *busPacket)
 //figures out if a rank's queue is empty
 bool CommandQueue::isEmpty(unsigned rank)
 {
-	if (queuingStructure == PerRank)
-	{
-		return queues[rank][0].empty();
-	}
-	else if (queuingStructure == PerRankPerBank)
-	{
-		for (size_t i=0;i<NUM_BANKS;i++)
-		{
-			if (!queues[rank][i].empty()) return false;
-		}
-		return true;
-	}
-	else
-	{
-		DEBUG("Invalid Queueing Stucture");
-		abort();
-	}
+	return rankOccupancy[rank] == 0;
 }
 
 //tells the command queue that a particular rank is in need of a refresh
@@ -718,30 +827,115 @@ void CommandQueue::needRefresh(unsigned rank)
 	refreshRank = rank;
 }
 
-void CommandQueue::nextRankAndBank(unsigned &rank, unsigned &bank)
+bool CommandQueue::isRefreshWaiting() const
 {
-	if (schedulingPolicy == RankThenBankRoundRobin)
+	return refreshWaiting;
+}
+
+//the first cycle in which pop() may precharge the open row of a bank that has
+//	nothing queued for it; 0 if that can't be told yet and (uint64_t)-1 if the
+//	row stays open until something is queued or a refresh is due
+uint64_t CommandQueue::idleRowCloseCycle(unsigned rank, unsigned bank) const
+{
+	//close page never leaves a row open on its own
+	if (config.rowBufferPolicy == ClosePage)
 	{
-		rank++;
-		if (rank == NUM_RANKS)
+		return 0;
+	}
+
+	uint64_t closeCycle = bankStates.nextPrecharge(rank, bank);
+	if (config.rowBufferPolicy == AdaptivePage && rowAccessCounters[rank][bank] != config.TOTAL_ROW_ACCESSES)
+	{
+		const PagePredictor &predictor = pagePredictors[rank][bank];
+		//the prediction is only made once pop() has seen the row idle
+		if (!predictor.pending)
 		{
-			rank = 0;
-			bank++;
-			if (bank == NUM_BANKS)
+			return 0;
+		}
+		if (predictor.keepOpen)
+		{
+			if (config.ROW_IDLE_TIMEOUT == 0)
 			{
-				bank = 0;
+				return (uint64_t)-1;
 			}
+			closeCycle = max(closeCycle, predictor.lastAccess + config.ROW_IDLE_TIMEOUT);
 		}
 	}
-	//bank-then-rank round robin
+	return closeCycle;
+}
+
+//returns the first occupied queue slot at or after slot, or numQueueSlots if there is none
+unsigned CommandQueue::nextOccupiedSlot(unsigned slot) const
+{
+	if (slot >= numQueueSlots)
+	{
+		return numQueueSlots;
+	}
+	size_t word = slot / 64;
+	uint64_t bits = occupiedQueues[word] & (~0ULL << (slot % 64));
+	while (bits == 0)
+	{
+		if (++word == occupiedQueues.size())
+		{
+			return numQueueSlots;
+		}
+		bits = occupiedQueues[word];
+	}
+	return word * 64 + __builtin_ctzll(bits);
+}
+
+//a queue's position in the round robin order that nextRankAndBank() walks;
+//	per rank queues just go in rank order
+template <QueuingStructure queuingStructure, SchedulingPolicy schedulingPolicy>
+unsigned CommandQueue::queueSlot(unsigned rank, unsigned bank) const
+{
+	if (queuingStructure == PerRank)
+	{
+		return rank;
+	}
 	else if (schedulingPolicy == BankThenRankRoundRobin)
+	{
+		return rank * config.NUM_BANKS + bank;
+	}
+	else
+	{
+		return bank * config.NUM_RANKS + rank;
+	}
+}
+
+template <QueuingStructure queuingStructure, SchedulingPolicy schedulingPolicy>
+void CommandQueue::slotRankAndBank(unsigned slot, unsigned &rank, unsigned &bank) const
+{
+	if (queuingStructure == PerRank)
+	{
+		rank = slot;
+		bank = 0;
+	}
+	else if (schedulingPolicy == BankThenRankRoundRobin)
+	{
+		rank = slot / config.NUM_BANKS;
+		bank = slot % config.NUM_BANKS;
+	}
+	else
+	{
+		rank = slot % config.NUM_RANKS;
+		bank = slot / config.NUM_RANKS;
+	}
+}
+
+//FR-FCFS walks the queues in the same order as rank-then-bank round robin
+template <SchedulingPolicy schedulingPolicy>
+void CommandQueue::nextRankAndBank(unsigned &rank, unsigned &bank)
+{
+	//bank-then-rank round robin
+	if (schedulingPolicy == BankThenRankRoundRobin)
 	{
 		bank++;
-		if (bank == NUM_BANKS)
+		if (bank == config.NUM_BANKS)
 		{
 			bank = 0;
 			rank++;
-			if (rank == NUM_RANKS)
+			if (rank == config.NUM_RANKS)
 			{
 				rank = 0;
 			}
@@ -749,10 +943,17 @@ void CommandQueue::nextRankAndBank(unsigned &rank, unsigned &bank)
 	}
 	else
 	{
-		ERROR("== Error - Unknown scheduling policy");
-		exit(0);
+		rank++;
+		if (rank == config.NUM_RANKS)
+		{
+			rank = 0;
+			bank++;
+			if (bank == config.NUM_BANKS)
+			{
+				bank = 0;
+			}
+		}
 	}
-
 }
 
 void CommandQueue::update()
@@ -46,6 +46,7 @@
 #include "Transaction.h"
 #include "SystemConfiguration.h"
 #include "SimulatorObject.h"
+#include "RollingWindow.h"
 
 using namespace std;
 
@@ -54,7 +55,10 @@ namespace DRAMSim
 class CommandQueue : public SimulatorObject
 {
 	CommandQueue();
+	const Config &config;
 	ostream &dramsim_log;
+	//the channel's count of the bus packets it allocates
+	PoolStats &busPacketAllocations;
 public:
 	//typedefs
 	typedef vector<BusPacket *> BusPacket1D;
@@ -62,7 +66,7 @@ public:
 	typedef vector<BusPacket2D> BusPacket3D;
 
 	//functions
-	CommandQueue(vector< vector<BankState> > &states, ostream &dramsim_log);
+	CommandQueue(BankStateTable &states, const Config &config, ostream &dramsim_log, PoolStats &busPacketAllocations);
 	virtual ~CommandQueue(); 
 
 	void enqueue(BusPacket *newBusPacket);
@@ -71,16 +75,63 @@ public:
 	bool isIssuable(BusPacket *busPacket);
 	bool isEmpty(unsigned rank);
 	void needRefresh(unsigned rank);
+	bool isRefreshWaiting() const;
+	uint64_t idleRowCloseCycle(unsigned rank, unsigned bank) const;
 	void print();
 	void update(); //SimulatorObject requirement
 	vector<BusPacket *> &getCommandQueue(unsigned rank, unsigned bank);
+	//adaptive_page: how many keep-open/close predictions have been checked
+	//	against the next access to their bank, and how many were right
+	uint64_t getPagePredictions() const
+	{
+		return pagePredictions;
+	}
+	uint64_t getCorrectPagePredictions() const
+	{
+		return correctPagePredictions;
+	}
+	void resetStats()
+	{
+		pagePredictions = 0;
+		correctPagePredictions = 0;
+	}
 
 	//fields
 	
 	BusPacket3D queues; // 3D array of BusPacket pointers
-	vector< vector<BankState> > &bankStates;
+	BankStateTable &bankStates;
 private:
+	//versions of enqueue() and pop() specialized on the configured policies;
+	//	the constructor picks one of each so that the hot paths don't
+	//	re-check the policies for every packet
+	template <QueuingStructure queuingStructure, SchedulingPolicy schedulingPolicy>
+	void enqueueWith(BusPacket *newBusPacket);
+	template <RowBufferPolicy rowBufferPolicy, QueuingStructure queuingStructure, SchedulingPolicy schedulingPolicy>
+	bool popWith(BusPacket **busPacket);
+	template <RowBufferPolicy rowBufferPolicy, QueuingStructure queuingStructure>
+	void selectPolicies();
+	template <RowBufferPolicy rowBufferPolicy, QueuingStructure queuingStructure, SchedulingPolicy schedulingPolicy>
+	bool issueNextQueued(BusPacket **busPacket);
+	template <RowBufferPolicy rowBufferPolicy, QueuingStructure queuingStructure, SchedulingPolicy schedulingPolicy>
+	bool searchQueues(bool columnAccessesOnly, BusPacket **busPacket);
+	template <RowBufferPolicy rowBufferPolicy, QueuingStructure queuingStructure, SchedulingPolicy schedulingPolicy>
+	bool issueFromQueue(unsigned rank, unsigned bank, bool columnAccessesOnly, BusPacket **busPacket);
+	template <QueuingStructure queuingStructure, SchedulingPolicy schedulingPolicy>
+	void removePackets(unsigned rank, unsigned bank, size_t first, size_t count);
+	template <QueuingStructure queuingStructure, SchedulingPolicy schedulingPolicy>
+	unsigned queueSlot(unsigned rank, unsigned bank) const;
+	template <QueuingStructure queuingStructure, SchedulingPolicy schedulingPolicy>
+	void slotRankAndBank(unsigned slot, unsigned &rank, unsigned &bank) const;
+	unsigned nextOccupiedSlot(unsigned slot) const;
+	bool keepIdleRowOpen(unsigned rank, unsigned bank);
+	void checkPagePrediction(BusPacket *busPacket);
+	template <QueuingStructure queuingStructure>
+	vector<BusPacket *> &queueFor(unsigned rank, unsigned bank);
+	template <SchedulingPolicy schedulingPolicy>
 	void nextRankAndBank(unsigned &rank, unsigned &bank);
+
+	void (CommandQueue::*enqueueFunction)(BusPacket *newBusPacket);
+	bool (CommandQueue::*popFunction)(BusPacket **busPacket);
 	//fields
 	unsigned nextBank;
 	unsigned nextRank;
@@ -91,9 +142,29 @@ private:
 	unsigned refreshRank;
 	bool refreshWaiting;
 
-	vector< vector<unsigned> > tFAWCountdown;
+	vector<RollingWindow> tFAWWindows;
 	vector< vector<unsigned> > rowAccessCounters;
 
+	//occupancy: packets queued per rank and a bit per non-empty queue
+	vector<unsigned> rankOccupancy;
+	vector<uint64_t> occupiedQueues;
+	unsigned numQueueSlots;
+
+	//adaptive_page: what each bank knows about its row buffer use
+	struct PagePredictor
+	{
+		//two bit saturating counter, 2 or more predicts the next access hits
+		unsigned counter;
+		//a prediction was made for the row that went idle and hasn't been checked yet
+		bool pending;
+		bool keepOpen;
+		unsigned row;
+		uint64_t lastAccess;
+	};
+	vector< vector<PagePredictor> > pagePredictors;
+	uint64_t pagePredictions;
+	uint64_t correctPagePredictions;
+
 	bool sendAct;
 };
 }
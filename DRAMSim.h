@@ -47,6 +47,10 @@ namespace DRAMSim
 			bool addTransaction(bool isWrite, uint64_t addr);
 			void setCPUClockSpeed(uint64_t cpuClkFreqHz);
 			void update();
+			uint64_t skipIdleCycles(uint64_t maxCycles);
+			bool isDrained();
+			uint64_t runUntilDrained(uint64_t maxCycles);
+			void enableParallelChannels(unsigned syncQuantum);
 			void printStats(bool finalStats);
 			bool willAcceptTransaction(); 
 			bool willAcceptTransaction(uint64_t addr); 
@@ -39,175 +39,94 @@
 
 using namespace std;
 
-// these are the values that are extern'd in SystemConfig.h so that they
-// have global scope even though they are set by IniReader
-
-uint64_t TOTAL_STORAGE;
-unsigned NUM_BANKS;
-unsigned NUM_BANKS_LOG;
-unsigned NUM_CHANS;
-unsigned NUM_CHANS_LOG;
-unsigned NUM_ROWS;
-unsigned NUM_ROWS_LOG;
-unsigned NUM_COLS;
-unsigned NUM_COLS_LOG;
-unsigned DEVICE_WIDTH;
-unsigned BYTE_OFFSET_WIDTH;
-unsigned TRANSACTION_SIZE;
-unsigned THROW_AWAY_BITS;
-unsigned COL_LOW_BIT_WIDTH;
-
-unsigned REFRESH_PERIOD;
-float tCK;
-float Vdd;
-unsigned CL;
-unsigned AL;
-unsigned BL;
-unsigned tRAS;
-unsigned tRCD;
-unsigned tRRD;
-unsigned tRC;
-unsigned tRP;
-unsigned tCCD;
-unsigned tRTP;
-unsigned tWTR;
-unsigned tWR;
-unsigned tRTRS;
-unsigned tRFC;
-unsigned tFAW;
-unsigned tCKE;
-unsigned tXP;
-unsigned tCMD;
-
-unsigned IDD0;
-unsigned IDD1;
-unsigned IDD2P;
-unsigned IDD2Q;
-unsigned IDD2N;
-unsigned IDD3Pf;
-unsigned IDD3Ps;
-unsigned IDD3N;
-unsigned IDD4W;
-unsigned IDD4R;
-unsigned IDD5;
-unsigned IDD6;
-unsigned IDD6L;
-unsigned IDD7;
-
-
-//in bytes
-unsigned JEDEC_DATA_BUS_BITS;
-
-//Memory Controller related parameters
-unsigned TRANS_QUEUE_DEPTH;
-unsigned CMD_QUEUE_DEPTH;
-
-//cycles within an epoch
-unsigned EPOCH_LENGTH;
-
-//row accesses allowed before closing (open page)
-unsigned TOTAL_ROW_ACCESSES;
-
-// strings and their associated enums
-string ROW_BUFFER_POLICY;
-string SCHEDULING_POLICY;
-string ADDRESS_MAPPING_SCHEME;
-string QUEUING_STRUCTURE;
-
-bool DEBUG_TRANS_Q;
-bool DEBUG_CMD_Q;
-bool DEBUG_ADDR_MAP;
-bool DEBUG_BANKSTATE;
-bool DEBUG_BUS;
-bool DEBUG_BANKS;
-bool DEBUG_POWER;
-bool USE_LOW_POWER;
-bool VIS_FILE_OUTPUT;
-
-bool VERIFICATION_OUTPUT;
-
 bool DEBUG_INI_READER=false;
 
 namespace DRAMSim
 {
-RowBufferPolicy rowBufferPolicy;
-SchedulingPolicy schedulingPolicy;
-AddressMappingScheme addressMappingScheme;
-QueuingStructure queuingStructure;
-
 
-//Map the string names to the variables they set
-static ConfigMap configMap[] =
+IniReader::IniReader(Config &config_) :
+	config(config_)
 {
-	//DEFINE_UINT_PARAM -- see IniReader.h
-	DEFINE_UINT_PARAM(NUM_BANKS,DEV_PARAM),
-	DEFINE_UINT_PARAM(NUM_ROWS,DEV_PARAM),
-	DEFINE_UINT_PARAM(NUM_COLS,DEV_PARAM),
-	DEFINE_UINT_PARAM(DEVICE_WIDTH,DEV_PARAM),
-	DEFINE_UINT_PARAM(REFRESH_PERIOD,DEV_PARAM),
-	DEFINE_FLOAT_PARAM(tCK,DEV_PARAM),
-	DEFINE_UINT_PARAM(CL,DEV_PARAM),
-	DEFINE_UINT_PARAM(AL,DEV_PARAM),
-	DEFINE_UINT_PARAM(BL,DEV_PARAM),
-	DEFINE_UINT_PARAM(tRAS,DEV_PARAM),
-	DEFINE_UINT_PARAM(tRCD,DEV_PARAM),
-	DEFINE_UINT_PARAM(tRRD,DEV_PARAM),
-	DEFINE_UINT_PARAM(tRC,DEV_PARAM),
-	DEFINE_UINT_PARAM(tRP,DEV_PARAM),
-	DEFINE_UINT_PARAM(tCCD,DEV_PARAM),
-	DEFINE_UINT_PARAM(tRTP,DEV_PARAM),
-	DEFINE_UINT_PARAM(tWTR,DEV_PARAM),
-	DEFINE_UINT_PARAM(tWR,DEV_PARAM),
-	DEFINE_UINT_PARAM(tRTRS,DEV_PARAM),
-	DEFINE_UINT_PARAM(tRFC,DEV_PARAM),
-	DEFINE_UINT_PARAM(tFAW,DEV_PARAM),
-	DEFINE_UINT_PARAM(tCKE,DEV_PARAM),
-	DEFINE_UINT_PARAM(tXP,DEV_PARAM),
-	DEFINE_UINT_PARAM(tCMD,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD0,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD1,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD2P,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD2Q,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD2N,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD3Pf,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD3Ps,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD3N,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD4W,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD4R,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD5,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD6,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD6L,DEV_PARAM),
-	DEFINE_UINT_PARAM(IDD7,DEV_PARAM),
-	DEFINE_FLOAT_PARAM(Vdd,DEV_PARAM),
-
-	DEFINE_UINT_PARAM(NUM_CHANS,SYS_PARAM),
-	DEFINE_UINT_PARAM(JEDEC_DATA_BUS_BITS,SYS_PARAM),
-
-	//Memory Controller related parameters
-	DEFINE_UINT_PARAM(TRANS_QUEUE_DEPTH,SYS_PARAM),
-	DEFINE_UINT_PARAM(CMD_QUEUE_DEPTH,SYS_PARAM),
-
-	DEFINE_UINT_PARAM(EPOCH_LENGTH,SYS_PARAM),
-	//Power
-	DEFINE_BOOL_PARAM(USE_LOW_POWER,SYS_PARAM),
-
-	DEFINE_UINT_PARAM(TOTAL_ROW_ACCESSES,SYS_PARAM),
-	DEFINE_STRING_PARAM(ROW_BUFFER_POLICY,SYS_PARAM),
-	DEFINE_STRING_PARAM(SCHEDULING_POLICY,SYS_PARAM),
-	DEFINE_STRING_PARAM(ADDRESS_MAPPING_SCHEME,SYS_PARAM),
-	DEFINE_STRING_PARAM(QUEUING_STRUCTURE,SYS_PARAM),
-	// debug flags
-	DEFINE_BOOL_PARAM(DEBUG_TRANS_Q,SYS_PARAM),
-	DEFINE_BOOL_PARAM(DEBUG_CMD_Q,SYS_PARAM),
-	DEFINE_BOOL_PARAM(DEBUG_ADDR_MAP,SYS_PARAM),
-	DEFINE_BOOL_PARAM(DEBUG_BANKSTATE,SYS_PARAM),
-	DEFINE_BOOL_PARAM(DEBUG_BUS,SYS_PARAM),
-	DEFINE_BOOL_PARAM(DEBUG_BANKS,SYS_PARAM),
-	DEFINE_BOOL_PARAM(DEBUG_POWER,SYS_PARAM),
-	DEFINE_BOOL_PARAM(VIS_FILE_OUTPUT,SYS_PARAM),
-	DEFINE_BOOL_PARAM(VERIFICATION_OUTPUT,SYS_PARAM),
-	{"", NULL, UINT, SYS_PARAM, false} // tracer value to signify end of list; if you delete it, epic fail will result
-};
+	//Map the string names to the variables they set
+	ConfigMap params[] =
+	{
+		//DEFINE_UINT_PARAM -- see IniReader.h
+		DEFINE_UINT_PARAM(NUM_BANKS,DEV_PARAM),
+		DEFINE_UINT_PARAM(NUM_ROWS,DEV_PARAM),
+		DEFINE_UINT_PARAM(NUM_COLS,DEV_PARAM),
+		DEFINE_UINT_PARAM(DEVICE_WIDTH,DEV_PARAM),
+		DEFINE_UINT_PARAM(REFRESH_PERIOD,DEV_PARAM),
+		DEFINE_FLOAT_PARAM(tCK,DEV_PARAM),
+		DEFINE_UINT_PARAM(CL,DEV_PARAM),
+		DEFINE_UINT_PARAM(AL,DEV_PARAM),
+		DEFINE_UINT_PARAM(BL,DEV_PARAM),
+		DEFINE_UINT_PARAM(tRAS,DEV_PARAM),
+		DEFINE_UINT_PARAM(tRCD,DEV_PARAM),
+		DEFINE_UINT_PARAM(tRRD,DEV_PARAM),
+		DEFINE_UINT_PARAM(tRC,DEV_PARAM),
+		DEFINE_UINT_PARAM(tRP,DEV_PARAM),
+		DEFINE_UINT_PARAM(tCCD,DEV_PARAM),
+		DEFINE_UINT_PARAM(tRTP,DEV_PARAM),
+		DEFINE_UINT_PARAM(tWTR,DEV_PARAM),
+		DEFINE_UINT_PARAM(tWR,DEV_PARAM),
+		DEFINE_UINT_PARAM(tRTRS,DEV_PARAM),
+		DEFINE_UINT_PARAM(tRFC,DEV_PARAM),
+		DEFINE_UINT_PARAM(tFAW,DEV_PARAM),
+		DEFINE_UINT_PARAM(tCKE,DEV_PARAM),
+		DEFINE_UINT_PARAM(tXP,DEV_PARAM),
+		DEFINE_UINT_PARAM(tCMD,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD0,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD1,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD2P,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD2Q,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD2N,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD3Pf,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD3Ps,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD3N,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD4W,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD4R,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD5,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD6,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD6L,DEV_PARAM),
+		DEFINE_UINT_PARAM(IDD7,DEV_PARAM),
+		DEFINE_FLOAT_PARAM(Vdd,DEV_PARAM),
+
+		DEFINE_UINT_PARAM(NUM_CHANS,SYS_PARAM),
+		DEFINE_UINT_PARAM(JEDEC_DATA_BUS_BITS,SYS_PARAM),
+
+		//Memory Controller related parameters
+		DEFINE_UINT_PARAM(TRANS_QUEUE_DEPTH,SYS_PARAM),
+		DEFINE_UINT_PARAM(CMD_QUEUE_DEPTH,SYS_PARAM),
+		DEFINE_UINT_PARAM_DEFAULT(WRITE_HIGH_WATERMARK,SYS_PARAM,0),
+		DEFINE_UINT_PARAM_DEFAULT(WRITE_LOW_WATERMARK,SYS_PARAM,0),
+		DEFINE_UINT_PARAM_DEFAULT(TRANS_DECODE_WIDTH,SYS_PARAM,1),
+		DEFINE_UINT_PARAM_DEFAULT(RETURN_BYTES_PER_CYCLE,SYS_PARAM,0),
+
+		DEFINE_UINT_PARAM(EPOCH_LENGTH,SYS_PARAM),
+		//Power
+		DEFINE_BOOL_PARAM(USE_LOW_POWER,SYS_PARAM),
+
+		DEFINE_UINT_PARAM(TOTAL_ROW_ACCESSES,SYS_PARAM),
+		DEFINE_UINT_PARAM_DEFAULT(ROW_IDLE_TIMEOUT,SYS_PARAM,0),
+		DEFINE_STRING_PARAM(ROW_BUFFER_POLICY,SYS_PARAM),
+		DEFINE_STRING_PARAM(SCHEDULING_POLICY,SYS_PARAM),
+		DEFINE_STRING_PARAM(ADDRESS_MAPPING_SCHEME,SYS_PARAM),
+		DEFINE_STRING_PARAM(QUEUING_STRUCTURE,SYS_PARAM),
+		// debug flags
+		DEFINE_BOOL_PARAM(DEBUG_TRANS_Q,SYS_PARAM),
+		DEFINE_BOOL_PARAM(DEBUG_CMD_Q,SYS_PARAM),
+		DEFINE_BOOL_PARAM(DEBUG_ADDR_MAP,SYS_PARAM),
+		DEFINE_BOOL_PARAM(DEBUG_BANKSTATE,SYS_PARAM),
+		DEFINE_BOOL_PARAM(DEBUG_BUS,SYS_PARAM),
+		DEFINE_BOOL_PARAM(DEBUG_BANKS,SYS_PARAM),
+		DEFINE_BOOL_PARAM(DEBUG_POWER,SYS_PARAM),
+		DEFINE_BOOL_PARAM(VIS_FILE_OUTPUT,SYS_PARAM),
+		DEFINE_BOOL_PARAM(VERIFICATION_OUTPUT,SYS_PARAM),
+		DEFINE_BOOL_PARAM(TRUST_CONTROLLER,SYS_PARAM),
+		{"", NULL, UINT, SYS_PARAM, false} // tracer value to signify end of list; if you delete it, epic fail will result
+	};
+	configMap.assign(params, params + sizeof(params)/sizeof(params[0]));
+}
 
 void IniReader::WriteParams(std::ofstream &visDataOut, paramType type)
 {
@@ -247,7 +166,7 @@ void IniReader::WriteParams(std::ofstream &visDataOut, paramType type)
 	}
 	if (type == SYS_PARAM)
 	{
-		visDataOut<<"NUM_RANKS="<<NUM_RANKS <<"\n";
+		visDataOut<<"NUM_RANKS="<<config.NUM_RANKS <<"\n";
 	}
 }
 void IniReader::WriteValuesOut(std::ofstream &visDataOut)
@@ -426,14 +345,14 @@ void IniReader::ReadIniFile(string filename, bool isSystemFile)
 		abort();
 	}
 	/* precompute frequently used values */
-	NUM_BANKS_LOG		= dramsim_log2(NUM_BANKS);
-	NUM_CHANS_LOG		= dramsim_log2(NUM_CHANS);
-	NUM_ROWS_LOG		= dramsim_log2(NUM_ROWS);
-	NUM_COLS_LOG		= dramsim_log2(NUM_COLS);
-	BYTE_OFFSET_WIDTH	= dramsim_log2(JEDEC_DATA_BUS_BITS / 8);
-	TRANSACTION_SIZE	= JEDEC_DATA_BUS_BITS / 8 * BL;
-	THROW_AWAY_BITS		= dramsim_log2(TRANSACTION_SIZE);
-	COL_LOW_BIT_WIDTH	= THROW_AWAY_BITS - BYTE_OFFSET_WIDTH;
+	config.NUM_BANKS_LOG		= dramsim_log2(config.NUM_BANKS);
+	config.NUM_CHANS_LOG		= dramsim_log2(config.NUM_CHANS);
+	config.NUM_ROWS_LOG		= dramsim_log2(config.NUM_ROWS);
+	config.NUM_COLS_LOG		= dramsim_log2(config.NUM_COLS);
+	config.BYTE_OFFSET_WIDTH	= dramsim_log2(config.JEDEC_DATA_BUS_BITS / 8);
+	config.TRANSACTION_SIZE	= config.JEDEC_DATA_BUS_BITS / 8 * config.BL;
+	config.THROW_AWAY_BITS		= dramsim_log2(config.TRANSACTION_SIZE);
+	config.COL_LOW_BIT_WIDTH	= config.THROW_AWAY_BITS - config.BYTE_OFFSET_WIDTH;
 }
 
 void IniReader::OverrideKeys(const OverrideMap *map)
@@ -452,6 +371,39 @@ void IniReader::OverrideKeys(const OverrideMap *map)
 	}
 }
 
+/** 
+ * Override options can be specified on the command line as -o key1=value1,key2=value2
+ * this method should parse the key-value pairs and put them into a map 
+ **/ 
+IniReader::OverrideMap *IniReader::ParseOverrides(const string &kv_str)
+{
+	OverrideMap *kv_map = new OverrideMap(); 
+	size_t start = 0, comma=0, equal_sign=0;
+	// split the commas if they are there
+	while (1)
+	{
+		equal_sign = kv_str.find('=', start); 
+		if (equal_sign == string::npos)
+		{
+			break;
+		}
+
+		comma = kv_str.find(',', equal_sign);
+		if (comma == string::npos)
+		{
+			comma = kv_str.length();
+		}
+
+		string key = kv_str.substr(start, equal_sign-start);
+		string value = kv_str.substr(equal_sign+1, comma-equal_sign-1); 
+
+		(*kv_map)[key] = value; 
+		start = comma+1;
+
+	}
+	return kv_map; 
+}
+
 bool IniReader::CheckIfAllSet()
 {
 	// check to make sure all parameters that we exepected were set
@@ -466,6 +418,12 @@ bool IniReader::CheckIfAllSet()
 			case UINT:
 			case UINT64:
 			case FLOAT:
+				if (configMap[i].defaultValue)
+				{
+					SetKey(configMap[i].iniKey, configMap[i].defaultValue);
+					DEBUG("\tSetting Default: "<<configMap[i].iniKey<<"="<<configMap[i].defaultValue);
+					break;
+				}
 				ERROR("Cannot continue without key '"<<configMap[i].iniKey<<"' set.");
 				return false;
 				break;
@@ -512,57 +470,57 @@ DEF_GETTER(IniReader::getFloat, float, FLOAT)
 
 void IniReader::InitEnumsFromStrings()
 {
-	if (ADDRESS_MAPPING_SCHEME == "scheme1")
+	if (config.ADDRESS_MAPPING_SCHEME == "scheme1")
 	{
-		addressMappingScheme = Scheme1;
+		config.addressMappingScheme = Scheme1;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ADDR SCHEME: 1");
 		}
 	}
-	else if (ADDRESS_MAPPING_SCHEME == "scheme2")
+	else if (config.ADDRESS_MAPPING_SCHEME == "scheme2")
 	{
-		addressMappingScheme = Scheme2;
+		config.addressMappingScheme = Scheme2;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ADDR SCHEME: 2");
 		}
 	}
-	else if (ADDRESS_MAPPING_SCHEME == "scheme3")
+	else if (config.ADDRESS_MAPPING_SCHEME == "scheme3")
 	{
-		addressMappingScheme = Scheme3;
+		config.addressMappingScheme = Scheme3;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ADDR SCHEME: 3");
 		}
 	}
-	else if (ADDRESS_MAPPING_SCHEME == "scheme4")
+	else if (config.ADDRESS_MAPPING_SCHEME == "scheme4")
 	{
-		addressMappingScheme = Scheme4;
+		config.addressMappingScheme = Scheme4;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ADDR SCHEME: 4");
 		}
 	}
-	else if (ADDRESS_MAPPING_SCHEME == "scheme5")
+	else if (config.ADDRESS_MAPPING_SCHEME == "scheme5")
 	{
-		addressMappingScheme = Scheme5;
+		config.addressMappingScheme = Scheme5;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ADDR SCHEME: 5");
 		}
 	}
-	else if (ADDRESS_MAPPING_SCHEME == "scheme6")
+	else if (config.ADDRESS_MAPPING_SCHEME == "scheme6")
 	{
-		addressMappingScheme = Scheme6;
+		config.addressMappingScheme = Scheme6;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ADDR SCHEME: 6");
 		}
 	}
-	else if (ADDRESS_MAPPING_SCHEME == "scheme7")
+	else if (config.ADDRESS_MAPPING_SCHEME == "scheme7")
 	{
-		addressMappingScheme = Scheme7;
+		config.addressMappingScheme = Scheme7;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ADDR SCHEME: 7");
@@ -570,43 +528,51 @@ void IniReader::InitEnumsFromStrings()
 	}
 	else
 	{
-		cout << "WARNING: unknown address mapping scheme '"<<ADDRESS_MAPPING_SCHEME<<"'; valid values are 'scheme1'...'scheme7'. Defaulting to scheme1"<<endl;
-		addressMappingScheme = Scheme1;
+		cout << "WARNING: unknown address mapping scheme '"<<config.ADDRESS_MAPPING_SCHEME<<"'; valid values are 'scheme1'...'scheme7'. Defaulting to scheme1"<<endl;
+		config.addressMappingScheme = Scheme1;
 	}
 
-	if (ROW_BUFFER_POLICY == "open_page")
+	if (config.ROW_BUFFER_POLICY == "open_page")
 	{
-		rowBufferPolicy = OpenPage;
+		config.rowBufferPolicy = OpenPage;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ROW BUFFER: open page");
 		}
 	}
-	else if (ROW_BUFFER_POLICY == "close_page")
+	else if (config.ROW_BUFFER_POLICY == "close_page")
 	{
-		rowBufferPolicy = ClosePage;
+		config.rowBufferPolicy = ClosePage;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("ROW BUFFER: close page");
 		}
 	}
+	else if (config.ROW_BUFFER_POLICY == "adaptive_page")
+	{
+		config.rowBufferPolicy = AdaptivePage;
+		if (DEBUG_INI_READER) 
+		{
+			DEBUG("ROW BUFFER: adaptive page");
+		}
+	}
 	else
 	{
-		cout << "WARNING: unknown row buffer policy '"<<ROW_BUFFER_POLICY<<"'; valid values are 'open_page' or 'close_page', Defaulting to Close Page."<<endl;
-		rowBufferPolicy = ClosePage;
+		cout << "WARNING: unknown row buffer policy '"<<config.ROW_BUFFER_POLICY<<"'; valid values are 'open_page', 'close_page' or 'adaptive_page', Defaulting to Close Page."<<endl;
+		config.rowBufferPolicy = ClosePage;
 	}
 
-	if (QUEUING_STRUCTURE == "per_rank_per_bank")
+	if (config.QUEUING_STRUCTURE == "per_rank_per_bank")
 	{
-		queuingStructure = PerRankPerBank;
+		config.queuingStructure = PerRankPerBank;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("QUEUING STRUCT: per rank per bank");
 		}
 	}
-	else if (QUEUING_STRUCTURE == "per_rank")
+	else if (config.QUEUING_STRUCTURE == "per_rank")
 	{
-		queuingStructure = PerRank;
+		config.queuingStructure = PerRank;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("QUEUING STRUCT: per rank");
@@ -614,30 +580,38 @@ void IniReader::InitEnumsFromStrings()
 	}
 	else
 	{
-		cout << "WARNING: Unknown queueing structure '"<<QUEUING_STRUCTURE<<"'; valid options are 'per_rank' and 'per_rank_per_bank', defaulting to Per Rank Per Bank"<<endl;
-		queuingStructure = PerRankPerBank;
+		cout << "WARNING: Unknown queueing structure '"<<config.QUEUING_STRUCTURE<<"'; valid options are 'per_rank' and 'per_rank_per_bank', defaulting to Per Rank Per Bank"<<endl;
+		config.queuingStructure = PerRankPerBank;
 	}
 
-	if (SCHEDULING_POLICY == "rank_then_bank_round_robin")
+	if (config.SCHEDULING_POLICY == "rank_then_bank_round_robin")
 	{
-		schedulingPolicy = RankThenBankRoundRobin;
+		config.schedulingPolicy = RankThenBankRoundRobin;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("SCHEDULING: Rank Then Bank");
 		}
 	}
-	else if (SCHEDULING_POLICY == "bank_then_rank_round_robin")
+	else if (config.SCHEDULING_POLICY == "bank_then_rank_round_robin")
 	{
-		schedulingPolicy = BankThenRankRoundRobin;
+		config.schedulingPolicy = BankThenRankRoundRobin;
 		if (DEBUG_INI_READER) 
 		{
 			DEBUG("SCHEDULING: Bank Then Rank");
 		}
 	}
+	else if (config.SCHEDULING_POLICY == "fr_fcfs")
+	{
+		config.schedulingPolicy = FRFCFS;
+		if (DEBUG_INI_READER) 
+		{
+			DEBUG("SCHEDULING: FR-FCFS");
+		}
+	}
 	else
 	{
-		cout << "WARNING: Unknown scheduling policy '"<<SCHEDULING_POLICY<<"'; valid options are 'rank_then_bank_round_robin' or 'bank_then_rank_round_robin'; defaulting to Bank Then Rank Round Robin" << endl;
-		schedulingPolicy = BankThenRankRoundRobin;
+		cout << "WARNING: Unknown scheduling policy '"<<config.SCHEDULING_POLICY<<"'; valid options are 'rank_then_bank_round_robin', 'bank_then_rank_round_robin' or 'fr_fcfs'; defaulting to Bank Then Rank Round Robin" << endl;
+		config.schedulingPolicy = BankThenRankRoundRobin;
 	}
 
 }
@@ -40,11 +40,13 @@
 
 using namespace std;
 
-#define DEFINE_UINT_PARAM(name, paramtype) {#name, &name, UINT, paramtype, false}
-#define DEFINE_STRING_PARAM(name, paramtype) {#name, &name, STRING, paramtype, false}
-#define DEFINE_FLOAT_PARAM(name,paramtype) {#name, &name, FLOAT, paramtype, false}
-#define DEFINE_BOOL_PARAM(name, paramtype) {#name, &name, BOOL, paramtype, false}
-#define DEFINE_UINT64_PARAM(name, paramtype) {#name, &name, UINT64, paramtype, false}
+#define DEFINE_UINT_PARAM(name, paramtype) {#name, &config.name, UINT, paramtype, false}
+#define DEFINE_STRING_PARAM(name, paramtype) {#name, &config.name, STRING, paramtype, false}
+#define DEFINE_FLOAT_PARAM(name,paramtype) {#name, &config.name, FLOAT, paramtype, false}
+#define DEFINE_BOOL_PARAM(name, paramtype) {#name, &config.name, BOOL, paramtype, false}
+#define DEFINE_UINT64_PARAM(name, paramtype) {#name, &config.name, UINT64, paramtype, false}
+//for numeric parameters that may be left out of the ini files
+#define DEFINE_UINT_PARAM_DEFAULT(name, paramtype, value) {#name, &config.name, UINT, paramtype, false, #value}
 
 namespace DRAMSim
 {
@@ -59,8 +61,11 @@ typedef struct _configMap
 	varType variableType;
 	paramType parameterType;
 	bool wasSet;
+	const char *defaultValue; //NULL if the parameter has to be set
 } ConfigMap;
 
+// Fills in the Config it was constructed with from the ini files and the
+// command line overrides
 class IniReader
 {
 
@@ -68,20 +73,27 @@ public:
 	typedef std::map<string, string> OverrideMap;
 	typedef OverrideMap::const_iterator OverrideIterator; 
 
-	static void SetKey(string key, string value, bool isSystemParam = false, size_t lineNumber = 0);
-	static void OverrideKeys(const OverrideMap *map);
-	static void ReadIniFile(string filename, bool isSystemParam);
-	static void InitEnumsFromStrings();
-	static bool CheckIfAllSet();
-	static void WriteValuesOut(std::ofstream &visDataOut);
-	static int getBool(const std::string &field, bool *val);
-	static int getUint(const std::string &field, unsigned int *val);
-	static int getUint64(const std::string &field, uint64_t *val);
-	static int getFloat(const std::string &field, float *val);
+	IniReader(Config &config);
+
+	void SetKey(string key, string value, bool isSystemParam = false, size_t lineNumber = 0);
+	static OverrideMap *ParseOverrides(const string &kv_str);
+	void OverrideKeys(const OverrideMap *map);
+	void ReadIniFile(string filename, bool isSystemParam);
+	void InitEnumsFromStrings();
+	bool CheckIfAllSet();
+	void WriteValuesOut(std::ofstream &visDataOut);
+	int getBool(const std::string &field, bool *val);
+	int getUint(const std::string &field, unsigned int *val);
+	int getUint64(const std::string &field, uint64_t *val);
+	int getFloat(const std::string &field, float *val);
 
 private:
-	static void WriteParams(std::ofstream &visDataOut, paramType t);
+	void WriteParams(std::ofstream &visDataOut, paramType t);
 	static void Trim(string &str);
+
+	Config &config;
+	//Map the string names to the variables they set
+	vector<ConfigMap> configMap;
 };
 }
 
@@ -37,36 +37,30 @@
 
 #include "MemoryController.h"
 #include "MemorySystem.h"
-#include "AddressMapping.h"
-
-#define SEQUENTIAL(rank,bank) (rank*NUM_BANKS)+bank
-
-/* Power computations are localized to MemoryController.cpp */ 
-extern unsigned IDD0;
-extern unsigned IDD1;
-extern unsigned IDD2P;
-extern unsigned IDD2Q;
-extern unsigned IDD2N;
-extern unsigned IDD3Pf;
-extern unsigned IDD3Ps;
-extern unsigned IDD3N;
-extern unsigned IDD4W;
-extern unsigned IDD4R;
-extern unsigned IDD5;
-extern unsigned IDD6;
-extern unsigned IDD6L;
-extern unsigned IDD7;
-extern float Vdd; 
+#include <assert.h>
+
+#define SEQUENTIAL(rank,bank) (rank*config.NUM_BANKS)+bank
 
 using namespace DRAMSim;
 
-MemoryController::MemoryController(MemorySystem *parent, CSVWriter &csvOut_, ostream &dramsim_log_) :
+MemoryController::MemoryController(MemorySystem *parent, const Config &config_, CSVWriter &csvOut_, ostream &dramsim_log_) :
+		transactionQueue(config_),
+		config(config_),
 		dramsim_log(dramsim_log_),
-		bankStates(NUM_RANKS, vector<BankState>(NUM_BANKS, dramsim_log)),
-		commandQueue(bankStates, dramsim_log_),
+		bankStates(config_, config.NUM_RANKS),
+		commandQueue(bankStates, config_, dramsim_log_, parent->busPacketAllocations),
 		poppedBusPacket(NULL),
+		numPendingReads(0),
+		returnBytesAvailable(0),
 		csvOut(csvOut_),
 		totalTransactions(0),
+		rowHits(0),
+		rowMisses(0),
+		columnAccessIssued(false),
+		lastAccessWasWrite(false),
+		readToWriteTurnarounds(0),
+		writeToReadTurnarounds(0),
+		frontEndLimitedCycles(0),
 		refreshRank(0)
 {
 	//get handle on parent
@@ -83,30 +77,28 @@ MemoryController::MemoryController(MemorySystem *parent, CSVWriter &csvOut_, ost
 	currentClockCycle = 0;
 
 	//reserve memory for vectors
-	transactionQueue.reserve(TRANS_QUEUE_DEPTH);
-	powerDown = vector<bool>(NUM_RANKS,false);
-	grandTotalBankAccesses = vector<uint64_t>(NUM_RANKS*NUM_BANKS,0);
-	totalReadsPerBank = vector<uint64_t>(NUM_RANKS*NUM_BANKS,0);
-	totalWritesPerBank = vector<uint64_t>(NUM_RANKS*NUM_BANKS,0);
-	totalReadsPerRank = vector<uint64_t>(NUM_RANKS,0);
-	totalWritesPerRank = vector<uint64_t>(NUM_RANKS,0);
-
-	writeDataCountdown.reserve(NUM_RANKS);
-	writeDataToSend.reserve(NUM_RANKS);
-	refreshCountdown.reserve(NUM_RANKS);
+	powerDown = vector<bool>(config.NUM_RANKS,false);
+	grandTotalBankAccesses = vector<uint64_t>(config.NUM_RANKS*config.NUM_BANKS,0);
+	totalReadsPerBank = vector<uint64_t>(config.NUM_RANKS*config.NUM_BANKS,0);
+	totalWritesPerBank = vector<uint64_t>(config.NUM_RANKS*config.NUM_BANKS,0);
+	totalReadsPerRank = vector<uint64_t>(config.NUM_RANKS,0);
+	totalWritesPerRank = vector<uint64_t>(config.NUM_RANKS,0);
+	activatedForAccess = vector<bool>(config.NUM_RANKS*config.NUM_BANKS,false);
+
+	nextRefresh.reserve(config.NUM_RANKS);
 
 	//Power related packets
-	backgroundEnergy = vector <uint64_t >(NUM_RANKS,0);
-	burstEnergy = vector <uint64_t> (NUM_RANKS,0);
-	actpreEnergy = vector <uint64_t> (NUM_RANKS,0);
-	refreshEnergy = vector <uint64_t> (NUM_RANKS,0);
+	backgroundEnergy = vector <uint64_t >(config.NUM_RANKS,0);
+	burstEnergy = vector <uint64_t> (config.NUM_RANKS,0);
+	actpreEnergy = vector <uint64_t> (config.NUM_RANKS,0);
+	refreshEnergy = vector <uint64_t> (config.NUM_RANKS,0);
 
-	totalEpochLatency = vector<uint64_t> (NUM_RANKS*NUM_BANKS,0);
+	totalEpochLatency = vector<uint64_t> (config.NUM_RANKS*config.NUM_BANKS,0);
 
 	//staggers when each rank is due for a refresh
-	for (size_t i=0;i<NUM_RANKS;i++)
+	for (size_t i=0;i<config.NUM_RANKS;i++)
 	{
-		refreshCountdown.push_back((int)((REFRESH_PERIOD/tCK)/NUM_RANKS)*(i+1));
+		nextRefresh.push_back((int)((config.REFRESH_PERIOD/config.tCK)/config.NUM_RANKS)*(i+1));
 	}
 }
 
@@ -116,18 +108,18 @@ void MemoryController::receiveFromBus(BusPacket *bpacket)
 	if (bpacket->busPacketType != DATA)
 	{
 		ERROR("== Error - Memory Controller received a non-DATA bus packet from rank");
-		bpacket->print();
+		bpacket->print(dramsim_log);
 		exit(0);
 	}
 
-	if (DEBUG_BUS)
+	if (config.DEBUG_BUS)
 	{
 		PRINTN(" -- MC Receiving From Data Bus : ");
-		bpacket->print();
+		bpacket->print(dramsim_log);
 	}
 
 	//add to return read data queue
-	returnTransaction.push_back(new Transaction(RETURN_DATA, bpacket->physicalAddress, bpacket->data));
+	returnTransaction.push_back(new (parentMemorySystem->transactionAllocations) Transaction(RETURN_DATA, bpacket->physicalAddress, bpacket->data));
 	totalReadsPerBank[SEQUENTIAL(bpacket->rank,bpacket->bank)]++;
 
 	// this delete statement saves a mindboggling amount of memory
@@ -155,38 +147,39 @@ void MemoryController::update()
 
 	//PRINT(" ------------------------- [" << currentClockCycle << "] -------------------------");
 
-	//update bank states
-	for (size_t i=0;i<NUM_RANKS;i++)
+	//update bank states whose implicit state change is due
+	while (!pendingStateChanges.empty() && pendingStateChanges.top().first <= currentClockCycle)
 	{
-		for (size_t j=0;j<NUM_BANKS;j++)
+		StateChange change = pendingStateChanges.top();
+		pendingStateChanges.pop();
+
+		unsigned i = change.second / config.NUM_BANKS;
+		unsigned j = change.second % config.NUM_BANKS;
+		//skip entries that have been superseded by a later command to this bank
+		if (bankStates.state(i, j).nextStateChange != change.first)
 		{
-			if (bankStates[i][j].stateChangeCountdown>0)
-			{
-				//decrement counters
-				bankStates[i][j].stateChangeCountdown--;
+			continue;
+		}
+		bankStates.state(i, j).nextStateChange = 0;
 
-				//if counter has reached 0, change state
-				if (bankStates[i][j].stateChangeCountdown == 0)
-				{
-					switch (bankStates[i][j].lastCommand)
-					{
-						//only these commands have an implicit state change
-					case WRITE_P:
-					case READ_P:
-						bankStates[i][j].currentBankState = Precharging;
-						bankStates[i][j].lastCommand = PRECHARGE;
-						bankStates[i][j].stateChangeCountdown = tRP;
-						break;
+		switch (bankStates.state(i, j).lastCommand)
+		{
+			//only these commands have an implicit state change
+		case WRITE_P:
+		case READ_P:
+			bankStates.rowClosed(i, j);
+			transactionQueue.rowClosed(i, j, bankStates.state(i, j).openRowAddress);
+			bankStates.state(i, j).currentBankState = Precharging;
+			bankStates.state(i, j).lastCommand = PRECHARGE;
+			scheduleStateChange(i, j, config.tRP);
+			break;
 
-					case REFRESH:
-					case PRECHARGE:
-						bankStates[i][j].currentBankState = Idle;
-						break;
-					default:
-						break;
-					}
-				}
-			}
+		case REFRESH:
+		case PRECHARGE:
+			bankStates.state(i, j).currentBankState = Idle;
+			break;
+		default:
+			break;
 		}
 	}
 
@@ -224,21 +217,16 @@ void MemoryController::update()
 	//and the appropriate amount of time has passed (WL)
 	//then send data on bus
 	//
-	//write data held in fifo vector along with countdowns
-	if (writeDataCountdown.size() > 0)
+	//write data held in fifo along with the cycle it is due on the bus
+	if (writeDataTime.size() > 0)
 	{
-		for (size_t i=0;i<writeDataCountdown.size();i++)
-		{
-			writeDataCountdown[i]--;
-		}
-
-		if (writeDataCountdown[0]==0)
+		if (writeDataTime.front() <= currentClockCycle)
 		{
 			//send to bus and print debug stuff
-			if (DEBUG_BUS)
+			if (config.DEBUG_BUS)
 			{
 				PRINTN(" -- MC Issuing On Data Bus    : ");
-				writeDataToSend[0]->print();
+				writeDataToSend.front()->print(dramsim_log);
 			}
 
 			// queue up the packet to be sent
@@ -248,32 +236,32 @@ void MemoryController::update()
 				exit(-1);
 			}
 
-			outgoingDataPacket = writeDataToSend[0];
-			dataCyclesLeft = BL/2;
+			outgoingDataPacket = writeDataToSend.front();
+			dataCyclesLeft = config.BL/2;
 
 			totalTransactions++;
-			totalWritesPerBank[SEQUENTIAL(writeDataToSend[0]->rank,writeDataToSend[0]->bank)]++;
+			totalWritesPerBank[SEQUENTIAL(outgoingDataPacket->rank,outgoingDataPacket->bank)]++;
 
-			writeDataCountdown.erase(writeDataCountdown.begin());
-			writeDataToSend.erase(writeDataToSend.begin());
+			writeDataTime.pop_front();
+			writeDataToSend.pop_front();
 		}
 	}
 
 	//if its time for a refresh issue a refresh
 	// else pop from command queue if it's not empty
-	if (refreshCountdown[refreshRank]==0)
+	if (nextRefresh[refreshRank] <= currentClockCycle)
 	{
 		commandQueue.needRefresh(refreshRank);
 		(*ranks)[refreshRank]->refreshWaiting = true;
-		refreshCountdown[refreshRank] =	 REFRESH_PERIOD/tCK;
+		nextRefresh[refreshRank] = currentClockCycle + (unsigned)(config.REFRESH_PERIOD/config.tCK);
 		refreshRank++;
-		if (refreshRank == NUM_RANKS)
+		if (refreshRank == config.NUM_RANKS)
 		{
 			refreshRank = 0;
 		}
 	}
 	//if a rank is powered down, make sure we power it up in time for a refresh
-	else if (powerDown[refreshRank] && refreshCountdown[refreshRank] <= tXP)
+	else if (powerDown[refreshRank] && nextRefresh[refreshRank] <= currentClockCycle + config.tXP)
 	{
 		(*ranks)[refreshRank]->refreshWaiting = true;
 	}
@@ -286,10 +274,10 @@ void MemoryController::update()
 		if (poppedBusPacket->busPacketType == WRITE || poppedBusPacket->busPacketType == WRITE_P)
 		{
 
-			writeDataToSend.push_back(new BusPacket(DATA, poppedBusPacket->physicalAddress, poppedBusPacket->column,
+			writeDataToSend.push_back(new (parentMemorySystem->busPacketAllocations) BusPacket(DATA, poppedBusPacket->physicalAddress, poppedBusPacket->column,
 			                                    poppedBusPacket->row, poppedBusPacket->rank, poppedBusPacket->bank,
-			                                    poppedBusPacket->data, dramsim_log));
-			writeDataCountdown.push_back(WL);
+			                                    poppedBusPacket->data));
+			writeDataTime.push_back(currentClockCycle + config.WL());
 		}
 
 		//
@@ -298,63 +286,85 @@ void MemoryController::update()
 		//for readability's sake
 		unsigned rank = poppedBusPacket->rank;
 		unsigned bank = poppedBusPacket->bank;
+
+		//a column access is a row hit unless its row was activated for it; also
+		//	count how often the data bus turns around between reads and writes
 		switch (poppedBusPacket->busPacketType)
 		{
 			case READ_P:
 			case READ:
-				//add energy to account for total
-				if (DEBUG_POWER)
-				{
-					PRINT(" ++ Adding Read energy to total energy");
-				}
-				burstEnergy[rank] += (IDD4R - IDD3N) * BL/2 * NUM_DEVICES;
-				if (poppedBusPacket->busPacketType == READ_P) 
+			case WRITE_P:
+			case WRITE:
+				if (activatedForAccess[SEQUENTIAL(rank,bank)])
 				{
-					//Don't bother setting next read or write times because the bank is no longer active
-					//bankStates[rank][bank].currentBankState = Idle;
-					bankStates[rank][bank].nextActivate = max(currentClockCycle + READ_AUTOPRE_DELAY,
-							bankStates[rank][bank].nextActivate);
-					bankStates[rank][bank].lastCommand = READ_P;
-					bankStates[rank][bank].stateChangeCountdown = READ_TO_PRE_DELAY;
+					activatedForAccess[SEQUENTIAL(rank,bank)] = false;
+					rowMisses++;
 				}
-				else if (poppedBusPacket->busPacketType == READ)
+				else
 				{
-					bankStates[rank][bank].nextPrecharge = max(currentClockCycle + READ_TO_PRE_DELAY,
-							bankStates[rank][bank].nextPrecharge);
-					bankStates[rank][bank].lastCommand = READ;
-
+					rowHits++;
 				}
-
-				for (size_t i=0;i<NUM_RANKS;i++)
 				{
-					for (size_t j=0;j<NUM_BANKS;j++)
+					bool isWrite = poppedBusPacket->busPacketType == WRITE || poppedBusPacket->busPacketType == WRITE_P;
+					if (columnAccessIssued && isWrite != lastAccessWasWrite)
 					{
-						if (i!=poppedBusPacket->rank)
+						if (isWrite)
 						{
-							//check to make sure it is active before trying to set (save's time?)
-							if (bankStates[i][j].currentBankState == RowActive)
-							{
-								bankStates[i][j].nextRead = max(currentClockCycle + BL/2 + tRTRS, bankStates[i][j].nextRead);
-								bankStates[i][j].nextWrite = max(currentClockCycle + READ_TO_WRITE_DELAY,
-										bankStates[i][j].nextWrite);
-							}
+							readToWriteTurnarounds++;
 						}
 						else
 						{
-							bankStates[i][j].nextRead = max(currentClockCycle + max(tCCD, BL/2), bankStates[i][j].nextRead);
-							bankStates[i][j].nextWrite = max(currentClockCycle + READ_TO_WRITE_DELAY,
-									bankStates[i][j].nextWrite);
+							writeToReadTurnarounds++;
 						}
 					}
+					columnAccessIssued = true;
+					lastAccessWasWrite = isWrite;
+				}
+				break;
+			case ACTIVATE:
+				activatedForAccess[SEQUENTIAL(rank,bank)] = true;
+				break;
+			default:
+				break;
+		}
+
+		switch (poppedBusPacket->busPacketType)
+		{
+			case READ_P:
+			case READ:
+				//add energy to account for total
+				if (config.DEBUG_POWER)
+				{
+					PRINT(" ++ Adding Read energy to total energy");
+				}
+				burstEnergy[rank] += (config.IDD4R - config.IDD3N) * config.BL/2 * config.NUM_DEVICES;
+				if (poppedBusPacket->busPacketType == READ_P) 
+				{
+					//Don't bother setting next read or write times because the bank is no longer active
+					//bankStates.state(rank, bank).currentBankState = Idle;
+					bankStates.nextActivate(rank, bank) = max(currentClockCycle + config.READ_AUTOPRE_DELAY(),
+							bankStates.nextActivate(rank, bank));
+					bankStates.state(rank, bank).lastCommand = READ_P;
+					scheduleStateChange(rank, bank, config.READ_TO_PRE_DELAY());
 				}
+				else if (poppedBusPacket->busPacketType == READ)
+				{
+					bankStates.nextPrecharge(rank, bank) = max(currentClockCycle + config.READ_TO_PRE_DELAY(),
+							bankStates.nextPrecharge(rank, bank));
+					bankStates.state(rank, bank).lastCommand = READ;
+
+				}
+
+				//holds up the column commands of this rank and of the other ranks' open banks
+				bankStates.readIssued(rank, currentClockCycle);
 
 				if (poppedBusPacket->busPacketType == READ_P)
 				{
 					//set read and write to nextActivate so the state table will prevent a read or write
 					//  being issued (in cq.isIssuable())before the bank state has been changed because of the
 					//  auto-precharge associated with this command
-					bankStates[rank][bank].nextRead = bankStates[rank][bank].nextActivate;
-					bankStates[rank][bank].nextWrite = bankStates[rank][bank].nextActivate;
+					bankStates.nextRead(rank, bank) = bankStates.nextActivate(rank, bank);
+					bankStates.nextWrite(rank, bank) = bankStates.nextActivate(rank, bank);
 				}
 
 				break;
@@ -362,107 +372,90 @@ void MemoryController::update()
 			case WRITE:
 				if (poppedBusPacket->busPacketType == WRITE_P) 
 				{
-					bankStates[rank][bank].nextActivate = max(currentClockCycle + WRITE_AUTOPRE_DELAY,
-							bankStates[rank][bank].nextActivate);
-					bankStates[rank][bank].lastCommand = WRITE_P;
-					bankStates[rank][bank].stateChangeCountdown = WRITE_TO_PRE_DELAY;
+					bankStates.nextActivate(rank, bank) = max(currentClockCycle + config.WRITE_AUTOPRE_DELAY(),
+							bankStates.nextActivate(rank, bank));
+					bankStates.state(rank, bank).lastCommand = WRITE_P;
+					scheduleStateChange(rank, bank, config.WRITE_TO_PRE_DELAY());
 				}
 				else if (poppedBusPacket->busPacketType == WRITE)
 				{
-					bankStates[rank][bank].nextPrecharge = max(currentClockCycle + WRITE_TO_PRE_DELAY,
-							bankStates[rank][bank].nextPrecharge);
-					bankStates[rank][bank].lastCommand = WRITE;
+					bankStates.nextPrecharge(rank, bank) = max(currentClockCycle + config.WRITE_TO_PRE_DELAY(),
+							bankStates.nextPrecharge(rank, bank));
+					bankStates.state(rank, bank).lastCommand = WRITE;
 				}
 
 
 				//add energy to account for total
-				if (DEBUG_POWER)
+				if (config.DEBUG_POWER)
 				{
 					PRINT(" ++ Adding Write energy to total energy");
 				}
-				burstEnergy[rank] += (IDD4W - IDD3N) * BL/2 * NUM_DEVICES;
+				burstEnergy[rank] += (config.IDD4W - config.IDD3N) * config.BL/2 * config.NUM_DEVICES;
 
-				for (size_t i=0;i<NUM_RANKS;i++)
-				{
-					for (size_t j=0;j<NUM_BANKS;j++)
-					{
-						if (i!=poppedBusPacket->rank)
-						{
-							if (bankStates[i][j].currentBankState == RowActive)
-							{
-								bankStates[i][j].nextWrite = max(currentClockCycle + BL/2 + tRTRS, bankStates[i][j].nextWrite);
-								bankStates[i][j].nextRead = max(currentClockCycle + WRITE_TO_READ_DELAY_R,
-										bankStates[i][j].nextRead);
-							}
-						}
-						else
-						{
-							bankStates[i][j].nextWrite = max(currentClockCycle + max(BL/2, tCCD), bankStates[i][j].nextWrite);
-							bankStates[i][j].nextRead = max(currentClockCycle + WRITE_TO_READ_DELAY_B,
-									bankStates[i][j].nextRead);
-						}
-					}
-				}
+				bankStates.writeIssued(rank, currentClockCycle);
 
 				//set read and write to nextActivate so the state table will prevent a read or write
 				//  being issued (in cq.isIssuable())before the bank state has been changed because of the
 				//  auto-precharge associated with this command
 				if (poppedBusPacket->busPacketType == WRITE_P)
 				{
-					bankStates[rank][bank].nextRead = bankStates[rank][bank].nextActivate;
-					bankStates[rank][bank].nextWrite = bankStates[rank][bank].nextActivate;
+					bankStates.nextRead(rank, bank) = bankStates.nextActivate(rank, bank);
+					bankStates.nextWrite(rank, bank) = bankStates.nextActivate(rank, bank);
 				}
 
 				break;
 			case ACTIVATE:
 				//add energy to account for total
-				if (DEBUG_POWER)
+				if (config.DEBUG_POWER)
 				{
 					PRINT(" ++ Adding Activate and Precharge energy to total energy");
 				}
-				actpreEnergy[rank] += ((IDD0 * tRC) - ((IDD3N * tRAS) + (IDD2N * (tRC - tRAS)))) * NUM_DEVICES;
+				actpreEnergy[rank] += ((config.IDD0 * config.tRC) - ((config.IDD3N * config.tRAS) + (config.IDD2N * (config.tRC - config.tRAS)))) * config.NUM_DEVICES;
 
-				bankStates[rank][bank].currentBankState = RowActive;
-				bankStates[rank][bank].lastCommand = ACTIVATE;
-				bankStates[rank][bank].openRowAddress = poppedBusPacket->row;
-				bankStates[rank][bank].nextActivate = max(currentClockCycle + tRC, bankStates[rank][bank].nextActivate);
-				bankStates[rank][bank].nextPrecharge = max(currentClockCycle + tRAS, bankStates[rank][bank].nextPrecharge);
+				bankStates.state(rank, bank).currentBankState = RowActive;
+				bankStates.state(rank, bank).lastCommand = ACTIVATE;
+				bankStates.state(rank, bank).openRowAddress = poppedBusPacket->row;
+				bankStates.rowOpened(rank, bank, currentClockCycle);
+				bankStates.nextActivate(rank, bank) = max(currentClockCycle + config.tRC, bankStates.nextActivate(rank, bank));
+				bankStates.nextPrecharge(rank, bank) = max(currentClockCycle + config.tRAS, bankStates.nextPrecharge(rank, bank));
 
 				//if we are using posted-CAS, the next column access can be sooner than normal operation
 
-				bankStates[rank][bank].nextRead = max(currentClockCycle + (tRCD-AL), bankStates[rank][bank].nextRead);
-				bankStates[rank][bank].nextWrite = max(currentClockCycle + (tRCD-AL), bankStates[rank][bank].nextWrite);
+				bankStates.nextRead(rank, bank) = max(currentClockCycle + (config.tRCD-config.AL), bankStates.nextRead(rank, bank));
+				bankStates.nextWrite(rank, bank) = max(currentClockCycle + (config.tRCD-config.AL), bankStates.nextWrite(rank, bank));
 
-				for (size_t i=0;i<NUM_BANKS;i++)
+				for (size_t i=0;i<config.NUM_BANKS;i++)
 				{
 					if (i!=poppedBusPacket->bank)
 					{
-						bankStates[rank][i].nextActivate = max(currentClockCycle + tRRD, bankStates[rank][i].nextActivate);
+						bankStates.nextActivate(rank, i) = max(currentClockCycle + config.tRRD, bankStates.nextActivate(rank, i));
 					}
 				}
 
 				break;
 			case PRECHARGE:
-				bankStates[rank][bank].currentBankState = Precharging;
-				bankStates[rank][bank].lastCommand = PRECHARGE;
-				bankStates[rank][bank].stateChangeCountdown = tRP;
-				bankStates[rank][bank].nextActivate = max(currentClockCycle + tRP, bankStates[rank][bank].nextActivate);
+				bankStates.rowClosed(rank, bank);
+				transactionQueue.rowClosed(rank, bank, bankStates.state(rank, bank).openRowAddress);
+				bankStates.state(rank, bank).currentBankState = Precharging;
+				bankStates.state(rank, bank).lastCommand = PRECHARGE;
+				scheduleStateChange(rank, bank, config.tRP);
+				bankStates.nextActivate(rank, bank) = max(currentClockCycle + config.tRP, bankStates.nextActivate(rank, bank));
 
 				break;
 			case REFRESH:
 				//add energy to account for total
-				if (DEBUG_POWER)
+				if (config.DEBUG_POWER)
 				{
 					PRINT(" ++ Adding Refresh energy to total energy");
 				}
-				refreshEnergy[rank] += (IDD5 - IDD3N) * tRFC * NUM_DEVICES;
+				refreshEnergy[rank] += (config.IDD5 - config.IDD3N) * config.tRFC * config.NUM_DEVICES;
 
-				for (size_t i=0;i<NUM_BANKS;i++)
+				for (size_t i=0;i<config.NUM_BANKS;i++)
 				{
-					bankStates[rank][i].nextActivate = currentClockCycle + tRFC;
-					bankStates[rank][i].currentBankState = Refreshing;
-					bankStates[rank][i].lastCommand = REFRESH;
-					bankStates[rank][i].stateChangeCountdown = tRFC;
+					bankStates.nextActivate(rank, i) = currentClockCycle + config.tRFC;
+					bankStates.state(rank, i).currentBankState = Refreshing;
+					bankStates.state(rank, i).lastCommand = REFRESH;
+					scheduleStateChange(rank, i, config.tRFC);
 				}
 
 				break;
@@ -472,10 +465,10 @@ void MemoryController::update()
 		}
 
 		//issue on bus and print debug
-		if (DEBUG_BUS)
+		if (config.DEBUG_BUS)
 		{
 			PRINTN(" -- MC Issuing On Command Bus : ");
-			poppedBusPacket->print();
+			poppedBusPacket->print(dramsim_log);
 		}
 
 		//check for collision on bus
@@ -485,105 +478,92 @@ void MemoryController::update()
 			exit(-1);
 		}
 		outgoingCmdPacket = poppedBusPacket;
-		cmdCyclesLeft = tCMD;
+		cmdCyclesLeft = config.tCMD;
 
 	}
 
-	for (size_t i=0;i<transactionQueue.size();i++)
+	//take the next transaction that there is room for in the command queue (the
+	//oldest one, or with FR-FCFS the oldest row hit) and break it up into the
+	//appropriate commands
+	//
+	//at most TRANS_DECODE_WIDTH transactions are scheduled per cycle; the
+	//default of one is a reasonable assumption considering how much logic
+	//would be required to schedule multiple entries per cycle (parallel data
+	//lines, switching logic, decision logic)
+	TransactionQueue::Entry entry;
+	unsigned decoded = 0;
+	while (decoded < config.TRANS_DECODE_WIDTH && transactionQueue.pop(commandQueue, entry))
 	{
-		//pop off top transaction from queue
-		//
-		//	assuming simple scheduling at the moment
-		//	will eventually add policies here
-		Transaction *transaction = transactionQueue[i];
-
-		//map address to rank,bank,row,col
-		unsigned newTransactionChan, newTransactionRank, newTransactionBank, newTransactionRow, newTransactionColumn;
+		decoded++;
+		Transaction *transaction = entry.trans;
 
-		// pass these in as references so they get set by the addressMapping function
-		addressMapping(transaction->address, newTransactionChan, newTransactionRank, newTransactionBank, newTransactionRow, newTransactionColumn);
-
-		//if we have room, break up the transaction into the appropriate commands
-		//and add them to the command queue
-		if (commandQueue.hasRoomFor(2, newTransactionRank, newTransactionBank))
+		if (config.DEBUG_ADDR_MAP) 
 		{
-			if (DEBUG_ADDR_MAP) 
+			PRINTN("== New Transaction - Mapping Address [0x" << hex << transaction->address << dec << "]");
+			if (transaction->transactionType == DATA_READ) 
 			{
-				PRINTN("== New Transaction - Mapping Address [0x" << hex << transaction->address << dec << "]");
-				if (transaction->transactionType == DATA_READ) 
-				{
-					PRINT(" (Read)");
-				}
-				else
-				{
-					PRINT(" (Write)");
-				}
-				PRINT("  Rank : " << newTransactionRank);
-				PRINT("  Bank : " << newTransactionBank);
-				PRINT("  Row  : " << newTransactionRow);
-				PRINT("  Col  : " << newTransactionColumn);
+				PRINT(" (Read)");
 			}
+			else
+			{
+				PRINT(" (Write)");
+			}
+			PRINT("  Rank : " << transaction->rank);
+			PRINT("  Bank : " << transaction->bank);
+			PRINT("  Row  : " << transaction->row);
+			PRINT("  Col  : " << transaction->column);
+		}
 
+		//create activate command to the row we just translated
+		BusPacket *ACTcommand = new (parentMemorySystem->busPacketAllocations) BusPacket(ACTIVATE, transaction->address,
+				transaction->column, transaction->row, transaction->rank,
+				transaction->bank, 0);
 
-
-			//now that we know there is room in the command queue, we can remove from the transaction queue
-			transactionQueue.erase(transactionQueue.begin()+i);
-
-			//create activate command to the row we just translated
-			BusPacket *ACTcommand = new BusPacket(ACTIVATE, transaction->address,
-					newTransactionColumn, newTransactionRow, newTransactionRank,
-					newTransactionBank, 0, dramsim_log);
-
-			//create read or write command and enqueue it
-			BusPacketType bpType = transaction->getBusPacketType();
-			BusPacket *command = new BusPacket(bpType, transaction->address,
-					newTransactionColumn, newTransactionRow, newTransactionRank,
-					newTransactionBank, transaction->data, dramsim_log);
+		//create read or write command and enqueue it
+		BusPacketType bpType = transaction->getBusPacketType(config.rowBufferPolicy);
+		BusPacket *command = new (parentMemorySystem->busPacketAllocations) BusPacket(bpType, transaction->address,
+				transaction->column, transaction->row, transaction->rank,
+				transaction->bank, transaction->data);
 
 
 
-			commandQueue.enqueue(ACTcommand);
-			commandQueue.enqueue(command);
+		commandQueue.enqueue(ACTcommand);
+		commandQueue.enqueue(command);
 
-			// If we have a read, save the transaction so when the data comes back
-			// in a bus packet, we can staple it back into a transaction and return it
-			if (transaction->transactionType == DATA_READ)
-			{
-				pendingReadTransactions.push_back(transaction);
-			}
-			else
-			{
-				// just delete the transaction now that it's a buspacket
-				delete transaction; 
-			}
-			/* only allow one transaction to be scheduled per cycle -- this should
-			 * be a reasonable assumption considering how much logic would be
-			 * required to schedule multiple entries per cycle (parallel data
-			 * lines, switching logic, decision logic)
-			 */
-			break;
+		// If we have a read, save the transaction so when the data comes back
+		// in a bus packet, we can staple it back into a transaction and return it
+		if (transaction->transactionType == DATA_READ)
+		{
+			pendingReadTransactions[transaction->address].push_back(transaction);
+			numPendingReads++;
 		}
-		else // no room, do nothing this cycle
+		else
 		{
-			//PRINT( "== Warning - No room in command queue" << endl;
+			// just delete the transaction now that it's a buspacket
+			delete transaction; 
 		}
 	}
+	//the front end was the bottleneck if there was more it could have scheduled
+	if (decoded == config.TRANS_DECODE_WIDTH && transactionQueue.hasSchedulable(commandQueue))
+	{
+		frontEndLimitedCycles++;
+	}
 
 
 	//calculate power
 	//  this is done on a per-rank basis, since power characterization is done per device (not per bank)
-	for (size_t i=0;i<NUM_RANKS;i++)
+	for (size_t i=0;i<config.NUM_RANKS;i++)
 	{
-		if (USE_LOW_POWER)
+		if (config.USE_LOW_POWER)
 		{
 			//if there are no commands in the queue and that particular rank is not waiting for a refresh...
 			if (commandQueue.isEmpty(i) && !(*ranks)[i]->refreshWaiting)
 			{
 				//check to make sure all banks are idle
 				bool allIdle = true;
-				for (size_t j=0;j<NUM_BANKS;j++)
+				for (size_t j=0;j<config.NUM_BANKS;j++)
 				{
-					if (bankStates[i][j].currentBankState != Idle)
+					if (bankStates.state(i, j).currentBankState != Idle)
 					{
 						allIdle = false;
 						break;
@@ -595,32 +575,32 @@ void MemoryController::update()
 				{
 					powerDown[i] = true;
 					(*ranks)[i]->powerDown();
-					for (size_t j=0;j<NUM_BANKS;j++)
+					for (size_t j=0;j<config.NUM_BANKS;j++)
 					{
-						bankStates[i][j].currentBankState = PowerDown;
-						bankStates[i][j].nextPowerUp = currentClockCycle + tCKE;
+						bankStates.state(i, j).currentBankState = PowerDown;
+						bankStates.state(i, j).nextPowerUp = currentClockCycle + config.tCKE;
 					}
 				}
 			}
 			//if there IS something in the queue or there IS a refresh waiting (and we can power up), do it
-			else if (currentClockCycle >= bankStates[i][0].nextPowerUp && powerDown[i]) //use 0 since theyre all the same
+			else if (currentClockCycle >= bankStates.state(i, 0).nextPowerUp && powerDown[i]) //use 0 since theyre all the same
 			{
 				powerDown[i] = false;
 				(*ranks)[i]->powerUp();
-				for (size_t j=0;j<NUM_BANKS;j++)
+				for (size_t j=0;j<config.NUM_BANKS;j++)
 				{
-					bankStates[i][j].currentBankState = Idle;
-					bankStates[i][j].nextActivate = currentClockCycle + tXP;
+					bankStates.state(i, j).currentBankState = Idle;
+					bankStates.nextActivate(i, j) = currentClockCycle + config.tXP;
 				}
 			}
 		}
 
 		//check for open bank
 		bool bankOpen = false;
-		for (size_t j=0;j<NUM_BANKS;j++)
+		for (size_t j=0;j<config.NUM_BANKS;j++)
 		{
-			if (bankStates[i][j].currentBankState == Refreshing ||
-			        bankStates[i][j].currentBankState == RowActive)
+			if (bankStates.state(i, j).currentBankState == Refreshing ||
+			        bankStates.state(i, j).currentBankState == RowActive)
 			{
 				bankOpen = true;
 				break;
@@ -630,118 +610,135 @@ void MemoryController::update()
 		//background power is dependent on whether or not a bank is open or not
 		if (bankOpen)
 		{
-			if (DEBUG_POWER)
+			if (config.DEBUG_POWER)
 			{
 				PRINT(" ++ Adding IDD3N to total energy [from rank "<< i <<"]");
 			}
-			backgroundEnergy[i] += IDD3N * NUM_DEVICES;
+			backgroundEnergy[i] += config.IDD3N * config.NUM_DEVICES;
 		}
 		else
 		{
 			//if we're in power-down mode, use the correct current
 			if (powerDown[i])
 			{
-				if (DEBUG_POWER)
+				if (config.DEBUG_POWER)
 				{
 					PRINT(" ++ Adding IDD2P to total energy [from rank " << i << "]");
 				}
-				backgroundEnergy[i] += IDD2P * NUM_DEVICES;
+				backgroundEnergy[i] += config.IDD2P * config.NUM_DEVICES;
 			}
 			else
 			{
-				if (DEBUG_POWER)
+				if (config.DEBUG_POWER)
 				{
 					PRINT(" ++ Adding IDD2N to total energy [from rank " << i << "]");
 				}
-				backgroundEnergy[i] += IDD2N * NUM_DEVICES;
+				backgroundEnergy[i] += config.IDD2N * config.NUM_DEVICES;
 			}
 		}
 	}
 
 	//check for outstanding data to return to the CPU
-	if (returnTransaction.size()>0)
+	//
+	//by default one read goes back per cycle; with RETURN_BYTES_PER_CYCLE set,
+	//	the link to the CPU moves that many bytes per cycle and a read goes back
+	//	whenever enough have accumulated for its burst
+	unsigned returnsThisCycle = 0;
+	if (returnTransaction.empty())
+	{
+		returnBytesAvailable = 0;
+	}
+	else if (config.RETURN_BYTES_PER_CYCLE == 0)
+	{
+		returnsThisCycle = 1;
+	}
+	else
+	{
+		unsigned bytesPerTransaction = (config.JEDEC_DATA_BUS_BITS*config.BL)/8;
+		returnBytesAvailable += config.RETURN_BYTES_PER_CYCLE;
+		returnsThisCycle = min<uint64_t>(returnBytesAvailable / bytesPerTransaction, returnTransaction.size());
+		returnBytesAvailable -= returnsThisCycle * bytesPerTransaction;
+		//an idle link can't save up bandwidth: if this empties the queue, a
+		//	read arriving before the next update must not find extra credit
+		if (returnsThisCycle == returnTransaction.size())
+		{
+			returnBytesAvailable = 0;
+		}
+		assert(returnBytesAvailable < bytesPerTransaction);
+	}
+	for (unsigned r=0; r<returnsThisCycle; r++)
 	{
-		if (DEBUG_BUS)
+		Transaction *returned = returnTransaction.front();
+		returnTransaction.pop_front();
+		if (config.DEBUG_BUS)
 		{
-			PRINTN(" -- MC Issuing to CPU bus : " << *returnTransaction[0]);
+			PRINTN(" -- MC Issuing to CPU bus : " << *returned);
 		}
 		totalTransactions++;
 
-		bool foundMatch=false;
 		//find the pending read transaction to calculate latency
-		for (size_t i=0;i<pendingReadTransactions.size();i++)
+		PendingReadMap::iterator it = pendingReadTransactions.find(returned->address);
+		if (it != pendingReadTransactions.end())
 		{
-			if (pendingReadTransactions[i]->address == returnTransaction[0]->address)
+			Transaction *pendingRead = it->second.front();
+			insertHistogram(currentClockCycle-pendingRead->timeAdded,pendingRead->rank,pendingRead->bank);
+			//return latency
+			returnReadData(pendingRead);
+
+			delete pendingRead;
+			it->second.pop_front();
+			if (it->second.empty())
 			{
-				//if(currentClockCycle - pendingReadTransactions[i]->timeAdded > 2000)
-				//	{
-				//		pendingReadTransactions[i]->print();
-				//		exit(0);
-				//	}
-				unsigned chan,rank,bank,row,col;
-				addressMapping(returnTransaction[0]->address,chan,rank,bank,row,col);
-				insertHistogram(currentClockCycle-pendingReadTransactions[i]->timeAdded,rank,bank);
-				//return latency
-				returnReadData(pendingReadTransactions[i]);
-
-				delete pendingReadTransactions[i];
-				pendingReadTransactions.erase(pendingReadTransactions.begin()+i);
-				foundMatch=true; 
-				break;
+				pendingReadTransactions.erase(it);
 			}
+			numPendingReads--;
 		}
-		if (!foundMatch)
+		else
 		{
-			ERROR("Can't find a matching transaction for 0x"<<hex<<returnTransaction[0]->address<<dec);
+			ERROR("Can't find a matching transaction for 0x"<<hex<<returned->address<<dec);
 			abort(); 
 		}
-		delete returnTransaction[0];
-		returnTransaction.erase(returnTransaction.begin());
-	}
-
-	//decrement refresh counters
-	for (size_t i=0;i<NUM_RANKS;i++)
-	{
-		refreshCountdown[i]--;
+		delete returned;
 	}
 
 	//
 	//print debug
 	//
-	if (DEBUG_TRANS_Q)
+	if (config.DEBUG_TRANS_Q)
 	{
 		PRINT("== Printing transaction queue");
-		for (size_t i=0;i<transactionQueue.size();i++)
+		vector<TransactionQueue::Entry> queued = transactionQueue.getAll();
+		for (size_t i=0;i<queued.size();i++)
 		{
-			PRINTN("  " << i << "] "<< *transactionQueue[i]);
+			PRINTN("  " << i << "] "<< *queued[i].trans);
 		}
 	}
 
-	if (DEBUG_BANKSTATE)
+	if (config.DEBUG_BANKSTATE)
 	{
 		//TODO: move this to BankState.cpp
 		PRINT("== Printing bank states (According to MC)");
-		for (size_t i=0;i<NUM_RANKS;i++)
+		for (size_t i=0;i<config.NUM_RANKS;i++)
 		{
-			for (size_t j=0;j<NUM_BANKS;j++)
+			for (size_t j=0;j<config.NUM_BANKS;j++)
 			{
-				if (bankStates[i][j].currentBankState == RowActive)
+				if (bankStates.state(i, j).currentBankState == RowActive)
 				{
-					PRINTN("[" << bankStates[i][j].openRowAddress << "] ");
+					PRINTN("[" << bankStates.state(i, j).openRowAddress << "] ");
 				}
-				else if (bankStates[i][j].currentBankState == Idle)
+				else if (bankStates.state(i, j).currentBankState == Idle)
 				{
 					PRINTN("[idle] ");
 				}
-				else if (bankStates[i][j].currentBankState == Precharging)
+				else if (bankStates.state(i, j).currentBankState == Precharging)
 				{
 					PRINTN("[pre] ");
 				}
-				else if (bankStates[i][j].currentBankState == Refreshing)
+				else if (bankStates.state(i, j).currentBankState == Refreshing)
 				{
 					PRINTN("[ref] ");
 				}
-				else if (bankStates[i][j].currentBankState == PowerDown)
+				else if (bankStates.state(i, j).currentBankState == PowerDown)
 				{
 					PRINTN("[lowp] ");
 				}
@@ -750,7 +747,7 @@ void MemoryController::update()
 		}
 	}
 
-	if (DEBUG_CMD_Q)
+	if (config.DEBUG_CMD_Q)
 	{
 		commandQueue.print();
 	}
@@ -759,9 +756,139 @@ void MemoryController::update()
 
 }
 
+/* 
+ * Returns how many of the upcoming cycles are guaranteed to do nothing but
+ * book-keeping (counters, clocks and background energy), or 0 if something
+ * might happen on the very next update(). Only a completely drained
+ * controller qualifies; the stretch ends at the next refresh (or the power-up
+ * ahead of it), the next time a bank finishes precharging/refreshing or the
+ * first cycle the command queue may close a row left open.
+ */
+uint64_t MemoryController::cyclesUntilNextEvent()
+{
+	//these print something every cycle, so we can't skip any
+	if (config.DEBUG_TRANS_Q || config.DEBUG_BANKSTATE || config.DEBUG_CMD_Q || config.DEBUG_POWER)
+	{
+		return 0;
+	}
+
+	if (!transactionQueue.empty() || !returnTransaction.empty() || !writeDataTime.empty() ||
+	        outgoingCmdPacket != NULL || outgoingDataPacket != NULL || commandQueue.isRefreshWaiting())
+	{
+		return 0;
+	}
+
+	//a powered down rank starts waking up tXP cycles ahead of its refresh
+	unsigned refreshThreshold = powerDown[refreshRank] ? config.tXP : 0;
+	if (nextRefresh[refreshRank] <= currentClockCycle + refreshThreshold)
+	{
+		return 0;
+	}
+	uint64_t cycles = nextRefresh[refreshRank] - currentClockCycle - refreshThreshold;
+
+	//the state changes on the update where it comes due
+	if (!pendingStateChanges.empty())
+	{
+		if (pendingStateChanges.top().first <= currentClockCycle + 1)
+		{
+			return 0;
+		}
+		cycles = min(cycles, pendingStateChanges.top().first - currentClockCycle - 1);
+	}
+
+	for (size_t i=0;i<config.NUM_RANKS;i++)
+	{
+		if (!commandQueue.isEmpty(i) || !(*ranks)[i]->isIdle() || (*ranks)[i]->refreshWaiting)
+		{
+			return 0;
+		}
+
+		bool allIdle = true;
+		for (size_t j=0;j<config.NUM_BANKS;j++)
+		{
+			//an open row stays open until the command queue precharges it
+			if (bankStates.state(i, j).currentBankState == RowActive)
+			{
+				uint64_t closeCycle = commandQueue.idleRowCloseCycle(i, j);
+				if (closeCycle <= currentClockCycle + 1)
+				{
+					return 0;
+				}
+				cycles = min(cycles, closeCycle - currentClockCycle - 1);
+			}
+			if (bankStates.state(i, j).currentBankState != Idle)
+			{
+				allIdle = false;
+			}
+		}
+
+		//an idle rank will be powered down on the next update
+		if (config.USE_LOW_POWER && allIdle)
+		{
+			return 0;
+		}
+	}
+
+	return cycles;
+}
+
+//true if every transaction handed to the controller has been completed: none
+//are queued, being scheduled, in flight on the buses or waiting to be returned
+bool MemoryController::isDrained()
+{
+	if (!transactionQueue.empty() || !pendingReadTransactions.empty() || !returnTransaction.empty() ||
+	        !writeDataToSend.empty() || outgoingCmdPacket != NULL || outgoingDataPacket != NULL)
+	{
+		return false;
+	}
+	for (size_t i=0;i<config.NUM_RANKS;i++)
+	{
+		if (!commandQueue.isEmpty(i) || !(*ranks)[i]->isIdle())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//does the book-keeping for a number of cycles that cyclesUntilNextEvent() has
+//said are idle, without going through update() for each one of them
+void MemoryController::skipCycles(uint64_t cycles)
+{
+	for (size_t i=0;i<config.NUM_RANKS;i++)
+	{
+		bool bankOpen = false;
+		for (size_t j=0;j<config.NUM_BANKS;j++)
+		{
+			if (bankStates.state(i, j).currentBankState == Refreshing ||
+			        bankStates.state(i, j).currentBankState == RowActive)
+			{
+				bankOpen = true;
+				break;
+			}
+		}
+
+		//same background power accounting as update()
+		if (bankOpen)
+		{
+			backgroundEnergy[i] += config.IDD3N * config.NUM_DEVICES * cycles;
+		}
+		else if (powerDown[i])
+		{
+			backgroundEnergy[i] += config.IDD2P * config.NUM_DEVICES * cycles;
+		}
+		else
+		{
+			backgroundEnergy[i] += config.IDD2N * config.NUM_DEVICES * cycles;
+		}
+	}
+
+	commandQueue.step(cycles);
+}
+
 bool MemoryController::WillAcceptTransaction()
 {
-	return transactionQueue.size() < TRANS_QUEUE_DEPTH;
+	return transactionQueue.size() < config.TRANS_QUEUE_DEPTH;
 }
 
 //allows outside source to make request of memory system
@@ -770,7 +897,7 @@ bool MemoryController::addTransaction(Transaction *trans)
 	if (WillAcceptTransaction())
 	{
 		trans->timeAdded = currentClockCycle;
-		transactionQueue.push_back(trans);
+		transactionQueue.push(trans);
 		return true;
 	}
 	else 
@@ -781,9 +908,9 @@ bool MemoryController::addTransaction(Transaction *trans)
 
 void MemoryController::resetStats()
 {
-	for (size_t i=0; i<NUM_RANKS; i++)
+	for (size_t i=0; i<config.NUM_RANKS; i++)
 	{
-		for (size_t j=0; j<NUM_BANKS; j++)
+		for (size_t j=0; j<config.NUM_BANKS; j++)
 		{
 			//XXX: this means the bank list won't be printed for partial epochs
 			grandTotalBankAccesses[SEQUENTIAL(i,j)] += totalReadsPerBank[SEQUENTIAL(i,j)] + totalWritesPerBank[SEQUENTIAL(i,j)];
@@ -799,6 +926,13 @@ void MemoryController::resetStats()
 		totalReadsPerRank[i] = 0;
 		totalWritesPerRank[i] = 0;
 	}
+	rowHits = 0;
+	rowMisses = 0;
+	readToWriteTurnarounds = 0;
+	writeToReadTurnarounds = 0;
+	frontEndLimitedCycles = 0;
+	transactionQueue.resetStats();
+	commandQueue.resetStats();
 }
 //prints statistics at the end of an epoch or  simulation
 void MemoryController::printStats(bool finalStats)
@@ -807,29 +941,29 @@ void MemoryController::printStats(bool finalStats)
 
 	//if we are not at the end of the epoch, make sure to adjust for the actual number of cycles elapsed
 
-	uint64_t cyclesElapsed = (currentClockCycle % EPOCH_LENGTH == 0) ? EPOCH_LENGTH : currentClockCycle % EPOCH_LENGTH;
-	unsigned bytesPerTransaction = (JEDEC_DATA_BUS_BITS*BL)/8;
+	uint64_t cyclesElapsed = (currentClockCycle % config.EPOCH_LENGTH == 0) ? config.EPOCH_LENGTH : currentClockCycle % config.EPOCH_LENGTH;
+	unsigned bytesPerTransaction = (config.JEDEC_DATA_BUS_BITS*config.BL)/8;
 	uint64_t totalBytesTransferred = totalTransactions * bytesPerTransaction;
-	double secondsThisEpoch = (double)cyclesElapsed * tCK * 1E-9;
+	double secondsThisEpoch = (double)cyclesElapsed * config.tCK * 1E-9;
 
 	// only per rank
-	vector<double> backgroundPower = vector<double>(NUM_RANKS,0.0);
-	vector<double> burstPower = vector<double>(NUM_RANKS,0.0);
-	vector<double> refreshPower = vector<double>(NUM_RANKS,0.0);
-	vector<double> actprePower = vector<double>(NUM_RANKS,0.0);
-	vector<double> averagePower = vector<double>(NUM_RANKS,0.0);
+	vector<double> backgroundPower = vector<double>(config.NUM_RANKS,0.0);
+	vector<double> burstPower = vector<double>(config.NUM_RANKS,0.0);
+	vector<double> refreshPower = vector<double>(config.NUM_RANKS,0.0);
+	vector<double> actprePower = vector<double>(config.NUM_RANKS,0.0);
+	vector<double> averagePower = vector<double>(config.NUM_RANKS,0.0);
 
 	// per bank variables
-	vector<double> averageLatency = vector<double>(NUM_RANKS*NUM_BANKS,0.0);
-	vector<double> bandwidth = vector<double>(NUM_RANKS*NUM_BANKS,0.0);
+	vector<double> averageLatency = vector<double>(config.NUM_RANKS*config.NUM_BANKS,0.0);
+	vector<double> bandwidth = vector<double>(config.NUM_RANKS*config.NUM_BANKS,0.0);
 
 	double totalBandwidth=0.0;
-	for (size_t i=0;i<NUM_RANKS;i++)
+	for (size_t i=0;i<config.NUM_RANKS;i++)
 	{
-		for (size_t j=0; j<NUM_BANKS; j++)
+		for (size_t j=0; j<config.NUM_BANKS; j++)
 		{
 			bandwidth[SEQUENTIAL(i,j)] = (((double)(totalReadsPerBank[SEQUENTIAL(i,j)]+totalWritesPerBank[SEQUENTIAL(i,j)]) * (double)bytesPerTransaction)/(1024.0*1024.0*1024.0)) / secondsThisEpoch;
-			averageLatency[SEQUENTIAL(i,j)] = ((float)totalEpochLatency[SEQUENTIAL(i,j)] / (float)(totalReadsPerBank[SEQUENTIAL(i,j)])) * tCK;
+			averageLatency[SEQUENTIAL(i,j)] = ((float)totalEpochLatency[SEQUENTIAL(i,j)] / (float)(totalReadsPerBank[SEQUENTIAL(i,j)])) * config.tCK;
 			totalBandwidth+=bandwidth[SEQUENTIAL(i,j)];
 			totalReadsPerRank[i] += totalReadsPerBank[SEQUENTIAL(i,j)];
 			totalWritesPerRank[i] += totalWritesPerBank[SEQUENTIAL(i,j)];
@@ -847,9 +981,23 @@ void MemoryController::printStats(bool finalStats)
 	PRINT( " ============== Printing Statistics [id:"<<parentMemorySystem->systemID<<"]==============" );
 	PRINTN( "   Total Return Transactions : " << totalTransactions );
 	PRINT( " ("<<totalBytesTransferred <<" bytes) aggregate average bandwidth "<<totalBandwidth<<"GB/s");
+	double rowHitRate = (rowHits + rowMisses == 0) ? 0.0 : (double)rowHits / (double)(rowHits + rowMisses) * 100.0;
+	PRINT( "   Row Hit Rate : " << rowHitRate << "% (" << rowHits << " of " << rowHits + rowMisses << " reads and writes)");
+	PRINT( "   Bus Turnarounds : " << readToWriteTurnarounds << " read to write, " << writeToReadTurnarounds << " write to read ("
+			<< transactionQueue.getWriteDrains() << " write drains)");
+	PRINT( "   Front End Limited : " << frontEndLimitedCycles << " of " << cyclesElapsed << " cycles (decoding "
+			<< config.TRANS_DECODE_WIDTH << " transactions per cycle)");
+	double pagePredictionAccuracy = 0.0;
+	if (config.rowBufferPolicy == AdaptivePage)
+	{
+		uint64_t predictions = commandQueue.getPagePredictions();
+		pagePredictionAccuracy = (predictions == 0) ? 0.0 : (double)commandQueue.getCorrectPagePredictions() / (double)predictions * 100.0;
+		PRINT( "   Page Predictions : " << pagePredictionAccuracy << "% correct (" << commandQueue.getCorrectPagePredictions()
+				<< " of " << predictions << " idle rows kept open or closed)");
+	}
 
 	double totalAggregateBandwidth = 0.0;	
-	for (size_t r=0;r<NUM_RANKS;r++)
+	for (size_t r=0;r<config.NUM_RANKS;r++)
 	{
 
 		PRINT( "      -Rank   "<<r<<" : ");
@@ -857,17 +1005,17 @@ void MemoryController::printStats(bool finalStats)
 		PRINT( " ("<<totalReadsPerRank[r] * bytesPerTransaction<<" bytes)");
 		PRINTN( "        -Writes : " << totalWritesPerRank[r]);
 		PRINT( " ("<<totalWritesPerRank[r] * bytesPerTransaction<<" bytes)");
-		for (size_t j=0;j<NUM_BANKS;j++)
+		for (size_t j=0;j<config.NUM_BANKS;j++)
 		{
 			PRINT( "        -Bandwidth / Latency  (Bank " <<j<<"): " <<bandwidth[SEQUENTIAL(r,j)] << " GB/s\t\t" <<averageLatency[SEQUENTIAL(r,j)] << " ns");
 		}
 
 		// factor of 1000 at the end is to account for the fact that totalEnergy is accumulated in mJ since IDD values are given in mA
-		backgroundPower[r] = ((double)backgroundEnergy[r] / (double)(cyclesElapsed)) * Vdd / 1000.0;
-		burstPower[r] = ((double)burstEnergy[r] / (double)(cyclesElapsed)) * Vdd / 1000.0;
-		refreshPower[r] = ((double) refreshEnergy[r] / (double)(cyclesElapsed)) * Vdd / 1000.0;
-		actprePower[r] = ((double)actpreEnergy[r] / (double)(cyclesElapsed)) * Vdd / 1000.0;
-		averagePower[r] = ((backgroundEnergy[r] + burstEnergy[r] + refreshEnergy[r] + actpreEnergy[r]) / (double)cyclesElapsed) * Vdd / 1000.0;
+		backgroundPower[r] = ((double)backgroundEnergy[r] / (double)(cyclesElapsed)) * config.Vdd / 1000.0;
+		burstPower[r] = ((double)burstEnergy[r] / (double)(cyclesElapsed)) * config.Vdd / 1000.0;
+		refreshPower[r] = ((double) refreshEnergy[r] / (double)(cyclesElapsed)) * config.Vdd / 1000.0;
+		actprePower[r] = ((double)actpreEnergy[r] / (double)(cyclesElapsed)) * config.Vdd / 1000.0;
+		averagePower[r] = ((backgroundEnergy[r] + burstEnergy[r] + refreshEnergy[r] + actpreEnergy[r]) / (double)cyclesElapsed) * config.Vdd / 1000.0;
 
 		if ((*parentMemorySystem->ReportPower)!=NULL)
 		{
@@ -881,7 +1029,7 @@ void MemoryController::printStats(bool finalStats)
 		PRINT( "     -Burst      (watts)     : " << burstPower[r]);
 		PRINT( "     -Refresh    (watts)     : " << refreshPower[r] );
 
-		if (VIS_FILE_OUTPUT)
+		if (config.VIS_FILE_OUTPUT)
 		{
 		//	cout << "c="<<myChannel<< " r="<<r<<"writing to csv out on cycle "<< currentClockCycle<<endl;
 			// write the vis file output
@@ -890,7 +1038,7 @@ void MemoryController::printStats(bool finalStats)
 			csvOut << CSVWriter::IndexedName("Burst_Power",myChannel,r) << burstPower[r];
 			csvOut << CSVWriter::IndexedName("Refresh_Power",myChannel,r) << refreshPower[r];
 			double totalRankBandwidth=0.0;
-			for (size_t b=0; b<NUM_BANKS; b++)
+			for (size_t b=0; b<config.NUM_BANKS; b++)
 			{
 				csvOut << CSVWriter::IndexedName("Bandwidth",myChannel,r,b) << bandwidth[SEQUENTIAL(r,b)];
 				totalRankBandwidth += bandwidth[SEQUENTIAL(r,b)];
@@ -898,13 +1046,22 @@ void MemoryController::printStats(bool finalStats)
 				csvOut << CSVWriter::IndexedName("Average_Latency",myChannel,r,b) << averageLatency[SEQUENTIAL(r,b)];
 			}
 			csvOut << CSVWriter::IndexedName("Rank_Aggregate_Bandwidth",myChannel,r) << totalRankBandwidth; 
-			csvOut << CSVWriter::IndexedName("Rank_Average_Bandwidth",myChannel,r) << totalRankBandwidth/NUM_RANKS; 
+			csvOut << CSVWriter::IndexedName("Rank_Average_Bandwidth",myChannel,r) << totalRankBandwidth/config.NUM_RANKS; 
 		}
 	}
-	if (VIS_FILE_OUTPUT)
+	if (config.VIS_FILE_OUTPUT)
 	{
 		csvOut << CSVWriter::IndexedName("Aggregate_Bandwidth",myChannel) << totalAggregateBandwidth;
-		csvOut << CSVWriter::IndexedName("Average_Bandwidth",myChannel) << totalAggregateBandwidth / (NUM_RANKS*NUM_BANKS);
+		csvOut << CSVWriter::IndexedName("Average_Bandwidth",myChannel) << totalAggregateBandwidth / (config.NUM_RANKS*config.NUM_BANKS);
+		csvOut << CSVWriter::IndexedName("Row_Hit_Rate",myChannel) << rowHitRate;
+		csvOut << CSVWriter::IndexedName("Read_To_Write_Turnarounds",myChannel) << readToWriteTurnarounds;
+		csvOut << CSVWriter::IndexedName("Write_To_Read_Turnarounds",myChannel) << writeToReadTurnarounds;
+		csvOut << CSVWriter::IndexedName("Write_Drains",myChannel) << transactionQueue.getWriteDrains();
+		csvOut << CSVWriter::IndexedName("Front_End_Limited_Cycles",myChannel) << frontEndLimitedCycles;
+		if (config.rowBufferPolicy == AdaptivePage)
+		{
+			csvOut << CSVWriter::IndexedName("Page_Prediction_Accuracy",myChannel) << pagePredictionAccuracy;
+		}
 	}
 
 	// only print the latency histogram at the end of the simulation since it clogs the output too much to print every epoch
@@ -912,7 +1069,7 @@ void MemoryController::printStats(bool finalStats)
 	{
 		PRINT( " ---  Latency list ("<<latencies.size()<<")");
 		PRINT( "       [lat] : #");
-		if (VIS_FILE_OUTPUT)
+		if (config.VIS_FILE_OUTPUT)
 		{
 			csvOut.getOutputStream() << "!!HISTOGRAM_DATA"<<endl;
 		}
@@ -921,18 +1078,18 @@ void MemoryController::printStats(bool finalStats)
 		for (it=latencies.begin(); it!=latencies.end(); it++)
 		{
 			PRINT( "       ["<< it->first <<"-"<<it->first+(HISTOGRAM_BIN_SIZE-1)<<"] : "<< it->second );
-			if (VIS_FILE_OUTPUT)
+			if (config.VIS_FILE_OUTPUT)
 			{
 				csvOut.getOutputStream() << it->first <<"="<< it->second << endl;
 			}
 		}
-		if (currentClockCycle % EPOCH_LENGTH == 0)
+		if (currentClockCycle % config.EPOCH_LENGTH == 0)
 		{
 			PRINT( " --- Grand Total Bank usage list");
-			for (size_t i=0;i<NUM_RANKS;i++)
+			for (size_t i=0;i<config.NUM_RANKS;i++)
 			{
 				PRINT("Rank "<<i<<":"); 
-				for (size_t j=0;j<NUM_BANKS;j++)
+				for (size_t j=0;j<config.NUM_BANKS;j++)
 				{
 					PRINT( "  b"<<j<<": "<<grandTotalBankAccesses[SEQUENTIAL(i,j)]);
 				}
@@ -942,7 +1099,7 @@ void MemoryController::printStats(bool finalStats)
 	}
 
 
-	PRINT(endl<< " == Pending Transactions : "<<pendingReadTransactions.size()<<" ("<<currentClockCycle<<")==");
+	PRINT(endl<< " == Pending Transactions : "<<numPendingReads<<" ("<<currentClockCycle<<")==");
 	/*
 	for(size_t i=0;i<pendingReadTransactions.size();i++)
 		{
@@ -959,9 +1116,12 @@ MemoryController::~MemoryController()
 {
 	//ERROR("MEMORY CONTROLLER DESTRUCTOR");
 	//abort();
-	for (size_t i=0; i<pendingReadTransactions.size(); i++)
+	for (PendingReadMap::iterator it=pendingReadTransactions.begin(); it != pendingReadTransactions.end(); it++)
 	{
-		delete pendingReadTransactions[i];
+		for (size_t i=0; i<it->second.size(); i++)
+		{
+			delete it->second[i];
+		}
 	}
 	for (size_t i=0; i<returnTransaction.size(); i++)
 	{
@@ -969,6 +1129,19 @@ MemoryController::~MemoryController()
 	}
 
 }
+//schedules the implicit state change of a bank 'delay' cycles from now;
+//a delay of 0 means there is no state change
+void MemoryController::scheduleStateChange(unsigned rank, unsigned bank, unsigned delay)
+{
+	if (delay == 0)
+	{
+		bankStates.state(rank, bank).nextStateChange = 0;
+		return;
+	}
+	bankStates.state(rank, bank).nextStateChange = currentClockCycle + delay;
+	pendingStateChanges.push(StateChange(currentClockCycle + delay, SEQUENTIAL(rank,bank)));
+}
+
 //inserts a latency into the latency histogram
 void MemoryController::insertHistogram(unsigned latencyValue, unsigned rank, unsigned bank)
 {
@@ -41,11 +41,15 @@
 #include "Transaction.h"
 #include "SystemConfiguration.h"
 #include "CommandQueue.h"
+#include "TransactionQueue.h"
 #include "BusPacket.h"
 #include "BankState.h"
 #include "Rank.h"
 #include "CSVWriter.h"
 #include <map>
+#include <unordered_map>
+#include <deque>
+#include <queue>
 
 using namespace std;
 
@@ -57,7 +61,7 @@ class MemoryController : public SimulatorObject
 
 public:
 	//functions
-	MemoryController(MemorySystem* ms, CSVWriter &csvOut_, ostream &dramsim_log_);
+	MemoryController(MemorySystem* ms, const Config &config_, CSVWriter &csvOut_, ostream &dramsim_log_);
 	virtual ~MemoryController();
 
 	bool addTransaction(Transaction *trans);
@@ -66,28 +70,47 @@ public:
 	void receiveFromBus(BusPacket *bpacket);
 	void attachRanks(vector<Rank *> *ranks);
 	void update();
+	uint64_t cyclesUntilNextEvent();
+	void skipCycles(uint64_t cycles);
+	bool isDrained();
 	void printStats(bool finalStats = false);
 	void resetStats(); 
 
 
 	//fields
-	vector<Transaction *> transactionQueue;
+	TransactionQueue transactionQueue;
 private:
+	const Config &config;
 	ostream &dramsim_log;
-	vector< vector <BankState> > bankStates;
+	BankStateTable bankStates;
 	//functions
 	void insertHistogram(unsigned latencyValue, unsigned rank, unsigned bank);
+	void scheduleStateChange(unsigned rank, unsigned bank, unsigned delay);
+
+	//(cycle, SEQUENTIAL(rank,bank)) pairs, earliest cycle on top
+	typedef pair<uint64_t, unsigned> StateChange;
+	typedef priority_queue<StateChange, vector<StateChange>, greater<StateChange> > StateChangeQueue;
 
 	//fields
 	MemorySystem *parentMemorySystem;
 
 	CommandQueue commandQueue;
 	BusPacket *poppedBusPacket;
-	vector<unsigned>refreshCountdown;
-	vector<BusPacket *> writeDataToSend;
-	vector<unsigned> writeDataCountdown;
-	vector<Transaction *> returnTransaction;
-	vector<Transaction *> pendingReadTransactions;
+	vector<uint64_t> nextRefresh;
+	StateChangeQueue pendingStateChanges;
+	//write data waits WL cycles before going on the bus; since WL is fixed
+	//these are always in order
+	deque<BusPacket *> writeDataToSend;
+	deque<uint64_t> writeDataTime;
+	//read data waiting to go back to the CPU, in the order it arrived
+	deque<Transaction *> returnTransaction;
+	//reads waiting for their data, by address; reads to the same address are
+	//returned in the order they were issued
+	typedef unordered_map<uint64_t, deque<Transaction *> > PendingReadMap;
+	PendingReadMap pendingReadTransactions;
+	size_t numPendingReads;
+	//bytes the return link can still move (see RETURN_BYTES_PER_CYCLE)
+	uint64_t returnBytesAvailable;
 	map<unsigned,unsigned> latencies; // latencyValue -> latencyCount
 	vector<bool> powerDown;
 
@@ -110,6 +133,21 @@ private:
 	vector<uint64_t> totalReadsPerRank;
 	vector<uint64_t> totalWritesPerRank;
 
+	//row buffer hits: a bank's flag is set by an activate and cleared by the
+	//	first read or write to the row it opened
+	vector<bool> activatedForAccess;
+	uint64_t rowHits;
+	uint64_t rowMisses;
+
+	//read/write turnarounds on the data bus
+	bool columnAccessIssued;
+	bool lastAccessWasWrite;
+	uint64_t readToWriteTurnarounds;
+	uint64_t writeToReadTurnarounds;
+
+	//cycles in which TRANS_DECODE_WIDTH transactions were scheduled and more could have been
+	uint64_t frontEndLimitedCycles;
+
 
 	vector< uint64_t > totalEpochLatency;
 
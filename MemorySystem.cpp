@@ -45,16 +45,15 @@ using namespace std;
 
 ofstream cmd_verify_out; //used in Rank.cpp and MemoryController.cpp if VERIFICATION_OUTPUT is set
 
-unsigned NUM_DEVICES;
-unsigned NUM_RANKS;
-unsigned NUM_RANKS_LOG;
-
 namespace DRAMSim {
 
 powerCallBack_t MemorySystem::ReportPower = NULL;
 
-MemorySystem::MemorySystem(unsigned id, unsigned int megsOfMemory, CSVWriter &csvOut_, ostream &dramsim_log_) :
+MemorySystem::MemorySystem(unsigned id, const Config &config_, CSVWriter &csvOut_, ostream &dramsim_log_) :
+		config(config_),
 		dramsim_log(dramsim_log_),
+		transactionAllocations(),
+		busPacketAllocations(),
 		ReturnReadData(NULL),
 		WriteDataDone(NULL),
 		systemID(id),
@@ -63,81 +62,17 @@ MemorySystem::MemorySystem(unsigned id, unsigned int megsOfMemory, CSVWriter &cs
 	currentClockCycle = 0;
 
 	DEBUG("===== MemorySystem "<<systemID<<" =====");
+	DEBUG("CH. " <<systemID<<" TOTAL_STORAGE : "<< config.TOTAL_STORAGE << "MB | "<<config.NUM_RANKS<<" Ranks | "<< config.NUM_DEVICES <<" Devices per rank");
 
 
-	//calculate the total storage based on the devices the user selected and the number of
-
-	//calculate number of devices
-	/************************
-	  This code has always been problematic even though it's pretty simple. I'll try to explain it 
-	  for my own sanity. 
-
-	  There are two main variables here that we could let the user choose:
-	  NUM_RANKS or TOTAL_STORAGE.  Since the density and width of the part is
-	  fixed by the device ini file, the only variable that is really
-	  controllable is the number of ranks. Users care more about choosing the
-	  total amount of storage, but with a fixed device they might choose a total
-	  storage that isn't possible. In that sense it's not as good to allow them
-	  to choose TOTAL_STORAGE (because any NUM_RANKS value >1 will be valid).
-
-	  However, users don't care (or know) about ranks, they care about total
-	  storage, so maybe it's better to let them choose and just throw an error
-	  if they choose something invalid. 
-
-	  A bit of background: 
-
-	  Each column contains DEVICE_WIDTH bits. A row contains NUM_COLS columns.
-	  Each bank contains NUM_ROWS rows. Therefore, the total storage per DRAM device is: 
-	  		PER_DEVICE_STORAGE = NUM_ROWS*NUM_COLS*DEVICE_WIDTH*NUM_BANKS (in bits)
-
-	 A rank *must* have a 64 bit output bus (JEDEC standard), so each rank must have:
-	  		NUM_DEVICES_PER_RANK = 64/DEVICE_WIDTH  
-			(note: if you have multiple channels ganged together, the bus width is 
-			effectively NUM_CHANS * 64/DEVICE_WIDTH)
-	 
-	If we multiply these two numbers to get the storage per rank (in bits), we get:
-			PER_RANK_STORAGE = PER_DEVICE_STORAGE*NUM_DEVICES_PER_RANK = NUM_ROWS*NUM_COLS*NUM_BANKS*64 
-
-	Finally, to get TOTAL_STORAGE, we need to multiply by NUM_RANKS
-			TOTAL_STORAGE = PER_RANK_STORAGE*NUM_RANKS (total storage in bits)
-
-	So one could compute this in reverse -- compute NUM_DEVICES,
-	PER_DEVICE_STORAGE, and PER_RANK_STORAGE first since all these parameters
-	are set by the device ini. Then, TOTAL_STORAGE/PER_RANK_STORAGE = NUM_RANKS 
-
-	The only way this could run into problems is if TOTAL_STORAGE < PER_RANK_STORAGE,
-	which could happen for very dense parts.
-	*********************/
-
-	// number of bytes per rank
-	unsigned long megsOfStoragePerRank = ((((long long)NUM_ROWS * (NUM_COLS * DEVICE_WIDTH) * NUM_BANKS) * ((long long)JEDEC_DATA_BUS_BITS / DEVICE_WIDTH)) / 8) >> 20;
-
-	// If this is set, effectively override the number of ranks
-	if (megsOfMemory != 0)
-	{
-		NUM_RANKS = megsOfMemory / megsOfStoragePerRank;
-		NUM_RANKS_LOG = dramsim_log2(NUM_RANKS);
-		if (NUM_RANKS == 0)
-		{
-			PRINT("WARNING: Cannot create memory system with "<<megsOfMemory<<"MB, defaulting to minimum size of "<<megsOfStoragePerRank<<"MB");
-			NUM_RANKS=1;
-		}
-	}
-
-	NUM_DEVICES = JEDEC_DATA_BUS_BITS/DEVICE_WIDTH;
-	TOTAL_STORAGE = (NUM_RANKS * megsOfStoragePerRank); 
-
-	DEBUG("CH. " <<systemID<<" TOTAL_STORAGE : "<< TOTAL_STORAGE << "MB | "<<NUM_RANKS<<" Ranks | "<< NUM_DEVICES <<" Devices per rank");
-
-
-	memoryController = new MemoryController(this, csvOut, dramsim_log);
+	memoryController = new MemoryController(this, config, csvOut, dramsim_log);
 
 	// TODO: change to other vector constructor?
 	ranks = new vector<Rank *>();
 
-	for (size_t i=0; i<NUM_RANKS; i++)
+	for (size_t i=0; i<config.NUM_RANKS; i++)
 	{
-		Rank *r = new Rank(dramsim_log);
+		Rank *r = new Rank(config, dramsim_log);
 		r->setId(i);
 		r->attachMemoryController(memoryController);
 		ranks->push_back(r);
@@ -157,14 +92,14 @@ MemorySystem::~MemorySystem()
 
 	delete(memoryController);
 
-	for (size_t i=0; i<NUM_RANKS; i++)
+	for (size_t i=0; i<config.NUM_RANKS; i++)
 	{
 		delete (*ranks)[i];
 	}
 	ranks->clear();
 	delete(ranks);
 
-	if (VERIFICATION_OUTPUT)
+	if (config.VERIFICATION_OUTPUT)
 	{
 		cmd_verify_out.flush();
 		cmd_verify_out.close();
@@ -180,9 +115,14 @@ bool MemorySystem::addTransaction(bool isWrite, uint64_t addr)
 {
 	TransactionType type = isWrite ? DATA_WRITE : DATA_READ;
 	Transaction *trans = new Transaction(type,addr,NULL);
-	// push_back in memoryController will make a copy of this during
-	// addTransaction so it's kosher for the reference to be local 
+	trans->mapAddress(config);
+	return acceptTransaction(trans);
+}
 
+//takes an already mapped transaction; if the controller is full it waits in
+//pendingTransactions, so this always accepts
+bool MemorySystem::acceptTransaction(Transaction *trans)
+{
 	if (memoryController->WillAcceptTransaction()) 
 	{
 		return memoryController->addTransaction(trans);
@@ -194,7 +134,16 @@ bool MemorySystem::addTransaction(bool isWrite, uint64_t addr)
 	}
 }
 
+//unlike acceptTransaction(), this returns false if the controller is full
+//	and the caller keeps the transaction
 bool MemorySystem::addTransaction(Transaction *trans)
+{
+	trans->mapAddress(config);
+	return addMappedTransaction(trans);
+}
+
+//same, for a transaction that has already been mapped
+bool MemorySystem::addMappedTransaction(Transaction *trans)
 {
 	return memoryController->addTransaction(trans);
 }
@@ -214,7 +163,7 @@ void MemorySystem::update()
 
 	//updates the state of each of the objects
 	// NOTE - do not change order
-	for (size_t i=0;i<NUM_RANKS;i++)
+	for (size_t i=0;i<config.NUM_RANKS;i++)
 	{
 		(*ranks)[i]->update();
 	}
@@ -228,7 +177,7 @@ void MemorySystem::update()
 	memoryController->update();
 
 	//simply increments the currentClockCycle field for each object
-	for (size_t i=0;i<NUM_RANKS;i++)
+	for (size_t i=0;i<config.NUM_RANKS;i++)
 	{
 		(*ranks)[i]->step();
 	}
@@ -238,6 +187,36 @@ void MemorySystem::update()
 	//PRINT("\n"); // two new lines
 }
 
+//number of upcoming cycles in which update() would only tick clocks and counters
+uint64_t MemorySystem::cyclesUntilNextEvent()
+{
+	if (pendingTransactions.size() > 0)
+	{
+		return 0;
+	}
+	return memoryController->cyclesUntilNextEvent();
+}
+
+//true if nothing that was added to this channel is still outstanding
+bool MemorySystem::isDrained()
+{
+	return pendingTransactions.empty() && memoryController->isDrained();
+}
+
+//equivalent to calling update() 'cycles' times, but only valid if
+//cyclesUntilNextEvent() returned at least that many cycles
+void MemorySystem::skipCycles(uint64_t cycles)
+{
+	memoryController->skipCycles(cycles);
+
+	for (size_t i=0;i<config.NUM_RANKS;i++)
+	{
+		(*ranks)[i]->step(cycles);
+	}
+	memoryController->step(cycles);
+	this->step(cycles);
+}
+
 void MemorySystem::RegisterCallbacks( Callback_t* readCB, Callback_t* writeCB,
                                       void (*reportPower)(double bgpower, double burstpower,
                                                           double refreshpower, double actprepower))
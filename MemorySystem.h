@@ -52,14 +52,20 @@ namespace DRAMSim
 typedef CallbackBase<void,unsigned,uint64_t,uint64_t> Callback_t;
 class MemorySystem : public SimulatorObject
 {
+	const Config &config;
 	ostream &dramsim_log;
 public:
 	//functions
-	MemorySystem(unsigned id, unsigned megsOfMemory, CSVWriter &csvOut_, ostream &dramsim_log_);
+	MemorySystem(unsigned id, const Config &config_, CSVWriter &csvOut_, ostream &dramsim_log_);
 	virtual ~MemorySystem();
 	void update();
+	uint64_t cyclesUntilNextEvent();
+	void skipCycles(uint64_t cycles);
+	bool isDrained();
 	bool addTransaction(Transaction *trans);
 	bool addTransaction(bool isWrite, uint64_t addr);
+	bool acceptTransaction(Transaction *trans);
+	bool addMappedTransaction(Transaction *trans);
 	void printStats(bool finalStats);
 	bool WillAcceptTransaction();
 	void RegisterCallbacks(
@@ -71,6 +77,10 @@ public:
 	MemoryController *memoryController;
 	vector<Rank *> *ranks;
 	deque<Transaction *> pendingTransactions; 
+	//pool allocations made by this channel's controller and command queue;
+	//	the transactions the host creates aren't included
+	PoolStats transactionAllocations;
+	PoolStats busPacketAllocations;
 
 
 	//function pointers
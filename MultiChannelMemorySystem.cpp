@@ -42,15 +42,93 @@
 
 using namespace DRAMSim; 
 
+// syncs that cover fewer cycles than this are simulated on the calling thread;
+// waking up the workers for them costs more than it saves
+static const unsigned MIN_PARALLEL_CYCLES = 64;
+
+/*
+ * In parallel mode each channel gets one of these. The worker thread updates
+ * its channel for all the cycles of a sync quantum; anything the host added in
+ * the meantime is replayed at the cycle it was added and anything the channel
+ * would have sent back to the host is held until the end of the quantum.
+ *
+ * queueBound is what the channel's transaction queue could at most hold at any
+ * point of the current quantum: what was queued or waiting when it started,
+ * plus whatever the host has added since. As long as it is below
+ * TRANS_QUEUE_DEPTH an add is sure to be accepted, so it can wait for replay.
+ */
+struct MultiChannelMemorySystem::ChannelWorker
+{
+	struct PendingAdd
+	{
+		unsigned cycleOffset; // number of pending cycles to run before adding it
+		Transaction *trans;
+	};
+	struct Completion
+	{
+		uint64_t cycle;
+		bool isWrite;
+		uint64_t addr;
+	};
+
+	MultiChannelMemorySystem *parent;
+	unsigned channel;
+	pthread_t thread;
+	unsigned seenGeneration;
+	vector<PendingAdd> pendingAdds;
+	size_t queueBound;
+	// what runChannel() is asked to do, and how far it got
+	uint64_t cyclesToRun;
+	bool stopWhenDrained;
+	uint64_t cyclesRun;
+	vector<Completion> completions;
+	TransactionCompleteCB *readDone;
+	TransactionCompleteCB *writeDone;
+
+	ChannelWorker(MultiChannelMemorySystem *parent_, unsigned channel_) :
+		parent(parent_), channel(channel_), seenGeneration(0), queueBound(0),
+		cyclesToRun(0), stopWhenDrained(false), cyclesRun(0)
+	{
+		readDone = new Callback<ChannelWorker, void, unsigned, uint64_t, uint64_t>(this, &ChannelWorker::readComplete);
+		writeDone = new Callback<ChannelWorker, void, unsigned, uint64_t, uint64_t>(this, &ChannelWorker::writeComplete);
+	}
+	~ChannelWorker()
+	{
+		for (size_t i=0; i<pendingAdds.size(); i++)
+		{
+			delete pendingAdds[i].trans;
+		}
+		delete readDone;
+		delete writeDone;
+	}
+	void readComplete(unsigned id, uint64_t addr, uint64_t cycle)
+	{
+		Completion c = {cycle, false, addr};
+		completions.push_back(c);
+	}
+	void writeComplete(unsigned id, uint64_t addr, uint64_t cycle)
+	{
+		Completion c = {cycle, true, addr};
+		completions.push_back(c);
+	}
+};
+
 
 MultiChannelMemorySystem::MultiChannelMemorySystem(const string &deviceIniFilename_, const string &systemIniFilename_, const string &pwd_, const string &traceFilename_, unsigned megsOfMemory_, string *visFilename_, const IniReader::OverrideMap *paramOverrides)
-	:megsOfMemory(megsOfMemory_), deviceIniFilename(deviceIniFilename_),
+	:config(), iniReader(config),
+	megsOfMemory(megsOfMemory_), deviceIniFilename(deviceIniFilename_),
 	systemIniFilename(systemIniFilename_), traceFilename(traceFilename_),
 	pwd(pwd_), visFilename(visFilename_), 
 	clockDomainCrosser(new ClockDomain::Callback<MultiChannelMemorySystem, void>(this, &MultiChannelMemorySystem::actual_update)),
-	csvOut(new CSVWriter(visDataOut))
+	csvOut(new CSVWriter(visDataOut)),
+	syncQuantum(0), pendingCycles(0),
+	hostReadDone(NULL), hostWriteDone(NULL),
+	syncGeneration(0), workersRunning(0), shuttingDown(false)
 {
 	currentClockCycle=0; 
+	pthread_mutex_init(&syncLock, NULL);
+	pthread_cond_init(&syncStart, NULL);
+	pthread_cond_init(&syncDone, NULL);
 	if (visFilename)
 		printf("CC VISFILENAME=%s\n",visFilename->c_str());
 
@@ -75,28 +153,107 @@ MultiChannelMemorySystem::MultiChannelMemorySystem(const string &deviceIniFilena
 	}
 
 	DEBUG("== Loading device model file '"<<deviceIniFilename<<"' == ");
-	IniReader::ReadIniFile(deviceIniFilename, false);
+	iniReader.ReadIniFile(deviceIniFilename, false);
 	DEBUG("== Loading system model file '"<<systemIniFilename<<"' == ");
-	IniReader::ReadIniFile(systemIniFilename, true);
+	iniReader.ReadIniFile(systemIniFilename, true);
 
 	// If we have any overrides, set them now before creating all of the memory objects
 	if (paramOverrides)
-		IniReader::OverrideKeys(paramOverrides);
+		iniReader.OverrideKeys(paramOverrides);
 
-	IniReader::InitEnumsFromStrings();
-	if (!IniReader::CheckIfAllSet())
+	iniReader.InitEnumsFromStrings();
+	if (!iniReader.CheckIfAllSet())
 	{
 		exit(-1);
 	}
 
-	if (NUM_CHANS == 0) 
+	if (config.NUM_CHANS == 0) 
 	{
 		ERROR("Zero channels"); 
 		abort(); 
 	}
-	for (size_t i=0; i<NUM_CHANS; i++)
+
+	if (config.WRITE_HIGH_WATERMARK > 0 &&
+			(config.WRITE_HIGH_WATERMARK > config.TRANS_QUEUE_DEPTH || config.WRITE_LOW_WATERMARK >= config.WRITE_HIGH_WATERMARK))
+	{
+		ERROR("WRITE_LOW_WATERMARK has to be below WRITE_HIGH_WATERMARK, which can't be more than TRANS_QUEUE_DEPTH");
+		abort();
+	}
+
+	if (config.TRANS_DECODE_WIDTH == 0)
+	{
+		ERROR("TRANS_DECODE_WIDTH has to be at least 1");
+		abort();
+	}
+
+	//every channel gets the same share of the memory
+	unsigned megsPerChannel = megsOfMemory/config.NUM_CHANS;
+
+	//calculate the total storage based on the devices the user selected and the number of
+
+	//calculate number of devices
+	/************************
+	  This code has always been problematic even though it's pretty simple. I'll try to explain it 
+	  for my own sanity. 
+
+	  There are two main variables here that we could let the user choose:
+	  NUM_RANKS or TOTAL_STORAGE.  Since the density and width of the part is
+	  fixed by the device ini file, the only variable that is really
+	  controllable is the number of ranks. Users care more about choosing the
+	  total amount of storage, but with a fixed device they might choose a total
+	  storage that isn't possible. In that sense it's not as good to allow them
+	  to choose TOTAL_STORAGE (because any NUM_RANKS value >1 will be valid).
+
+	  However, users don't care (or know) about ranks, they care about total
+	  storage, so maybe it's better to let them choose and just throw an error
+	  if they choose something invalid. 
+
+	  A bit of background: 
+
+	  Each column contains DEVICE_WIDTH bits. A row contains NUM_COLS columns.
+	  Each bank contains NUM_ROWS rows. Therefore, the total storage per DRAM device is: 
+	  		PER_DEVICE_STORAGE = NUM_ROWS*NUM_COLS*DEVICE_WIDTH*NUM_BANKS (in bits)
+
+	 A rank *must* have a 64 bit output bus (JEDEC standard), so each rank must have:
+	  		NUM_DEVICES_PER_RANK = 64/DEVICE_WIDTH  
+			(note: if you have multiple channels ganged together, the bus width is 
+			effectively NUM_CHANS * 64/DEVICE_WIDTH)
+	 
+	If we multiply these two numbers to get the storage per rank (in bits), we get:
+			PER_RANK_STORAGE = PER_DEVICE_STORAGE*NUM_DEVICES_PER_RANK = NUM_ROWS*NUM_COLS*NUM_BANKS*64 
+
+	Finally, to get TOTAL_STORAGE, we need to multiply by NUM_RANKS
+			TOTAL_STORAGE = PER_RANK_STORAGE*NUM_RANKS (total storage in bits)
+
+	So one could compute this in reverse -- compute NUM_DEVICES,
+	PER_DEVICE_STORAGE, and PER_RANK_STORAGE first since all these parameters
+	are set by the device ini. Then, TOTAL_STORAGE/PER_RANK_STORAGE = NUM_RANKS 
+
+	The only way this could run into problems is if TOTAL_STORAGE < PER_RANK_STORAGE,
+	which could happen for very dense parts.
+	*********************/
+
+	// number of bytes per rank
+	unsigned long megsOfStoragePerRank = ((((long long)config.NUM_ROWS * (config.NUM_COLS * config.DEVICE_WIDTH) * config.NUM_BANKS) * ((long long)config.JEDEC_DATA_BUS_BITS / config.DEVICE_WIDTH)) / 8) >> 20;
+
+	// If this is set, effectively override the number of ranks
+	if (megsPerChannel != 0)
+	{
+		config.NUM_RANKS = megsPerChannel / megsOfStoragePerRank;
+		config.NUM_RANKS_LOG = dramsim_log2(config.NUM_RANKS);
+		if (config.NUM_RANKS == 0)
+		{
+			PRINT("WARNING: Cannot create memory system with "<<megsPerChannel<<"MB, defaulting to minimum size of "<<megsOfStoragePerRank<<"MB");
+			config.NUM_RANKS=1;
+		}
+	}
+
+	config.NUM_DEVICES = config.JEDEC_DATA_BUS_BITS/config.DEVICE_WIDTH;
+	config.TOTAL_STORAGE = (config.NUM_RANKS * megsOfStoragePerRank);
+
+	for (size_t i=0; i<config.NUM_CHANS; i++)
 	{
-		MemorySystem *channel = new MemorySystem(i, megsOfMemory/NUM_CHANS, (*csvOut), dramsim_log);
+		MemorySystem *channel = new MemorySystem(i, config, (*csvOut), dramsim_log);
 		channels.push_back(channel);
 	}
 }
@@ -106,7 +263,7 @@ MultiChannelMemorySystem::MultiChannelMemorySystem(const string &deviceIniFilena
 void MultiChannelMemorySystem::setCPUClockSpeed(uint64_t cpuClkFreqHz)
 {
 
-	uint64_t dramsimClkFreqHz = (uint64_t)(1.0/(tCK*1e-9));
+	uint64_t dramsimClkFreqHz = (uint64_t)(1.0/(config.tCK*1e-9));
 	clockDomainCrosser.clock1 = dramsimClkFreqHz; 
 	clockDomainCrosser.clock2 = (cpuClkFreqHz == 0) ? dramsimClkFreqHz : cpuClkFreqHz; 
 }
@@ -181,7 +338,7 @@ void MultiChannelMemorySystem::InitOutputFiles(string traceFilename)
 
 	// create a properly named verification output file if need be and open it
 	// as the stream 'cmd_verify_out'
-	if (VERIFICATION_OUTPUT)
+	if (config.VERIFICATION_OUTPUT)
 	{
 		string basefilename = deviceIniFilename.substr(deviceIniFilename.find_last_of("/")+1);
 		string verify_filename =  "sim_out_"+basefilename;
@@ -199,7 +356,7 @@ void MultiChannelMemorySystem::InitOutputFiles(string traceFilename)
 	}
 	// This sets up the vis file output along with the creating the result
 	// directory structure if it doesn't exist
-	if (VIS_FILE_OUTPUT)
+	if (config.VIS_FILE_OUTPUT)
 	{
 		stringstream out,tmpNum;
 		string path;
@@ -247,17 +404,21 @@ void MultiChannelMemorySystem::InitOutputFiles(string traceFilename)
 			// finally, figure out the filename
 			string sched = "BtR";
 			string queue = "pRank";
-			if (schedulingPolicy == RankThenBankRoundRobin)
+			if (config.schedulingPolicy == RankThenBankRoundRobin)
 			{
 				sched = "RtB";
 			}
-			if (queuingStructure == PerRankPerBank)
+			else if (config.schedulingPolicy == FRFCFS)
+			{
+				sched = "FRFCFS";
+			}
+			if (config.queuingStructure == PerRankPerBank)
 			{
 				queue = "pRankpBank";
 			}
 
 			/* I really don't see how "the C++ way" is better than snprintf()  */
-			out << (TOTAL_STORAGE>>10) << "GB." << NUM_CHANS << "Ch." << NUM_RANKS <<"R." <<ADDRESS_MAPPING_SCHEME<<"."<<ROW_BUFFER_POLICY<<"."<< TRANS_QUEUE_DEPTH<<"TQ."<<CMD_QUEUE_DEPTH<<"CQ."<<sched<<"."<<queue;
+			out << (config.TOTAL_STORAGE>>10) << "GB." << config.NUM_CHANS << "Ch." << config.NUM_RANKS <<"R." <<config.ADDRESS_MAPPING_SCHEME<<"."<<config.ROW_BUFFER_POLICY<<"."<< config.TRANS_QUEUE_DEPTH<<"TQ."<<config.CMD_QUEUE_DEPTH<<"CQ."<<sched<<"."<<queue;
 		}
 		else //visFilename given
 		{
@@ -284,7 +445,7 @@ void MultiChannelMemorySystem::InitOutputFiles(string traceFilename)
 			exit(-1);
 		}
 		//write out the ini config values for the visualizer tool
-		IniReader::WriteValuesOut(visDataOut);
+		iniReader.WriteValuesOut(visDataOut);
 
 	}
 	else
@@ -350,7 +511,26 @@ void MultiChannelMemorySystem::mkdirIfNotExist(string path)
 
 MultiChannelMemorySystem::~MultiChannelMemorySystem()
 {
-	for (size_t i=0; i<NUM_CHANS; i++)
+	// finish whatever the host has already clocked and stop the workers
+	syncChannels();
+	pthread_mutex_lock(&syncLock);
+	shuttingDown = true;
+	pthread_cond_broadcast(&syncStart);
+	pthread_mutex_unlock(&syncLock);
+	for (size_t i=0; i<workers.size(); i++)
+	{
+		if (i > 0)
+		{
+			pthread_join(workers[i]->thread, NULL);
+		}
+		delete workers[i];
+	}
+	workers.clear();
+	pthread_mutex_destroy(&syncLock);
+	pthread_cond_destroy(&syncStart);
+	pthread_cond_destroy(&syncDone);
+
+	for (size_t i=0; i<config.NUM_CHANS; i++)
 	{
 		delete channels[i];
 	}
@@ -361,7 +541,7 @@ MultiChannelMemorySystem::~MultiChannelMemorySystem()
 	dramsim_log.flush();
 	dramsim_log.close();
 #endif
-	if (VIS_FILE_OUTPUT) 
+	if (config.VIS_FILE_OUTPUT) 
 	{	
 		visDataOut.flush();
 		visDataOut.close();
@@ -379,45 +559,386 @@ void MultiChannelMemorySystem::actual_update()
 		DEBUG("DRAMSim2 Clock Frequency ="<<clockDomainCrosser.clock1<<"Hz, CPU Clock Frequency="<<clockDomainCrosser.clock2<<"Hz"); 
 	}
 
-	if (currentClockCycle % EPOCH_LENGTH == 0)
+	if (currentClockCycle % config.EPOCH_LENGTH == 0)
 	{
-		(*csvOut) << "ms" <<currentClockCycle * tCK * 1E-6; 
-		for (size_t i=0; i<NUM_CHANS; i++)
+		syncChannels();
+		(*csvOut) << "ms" <<currentClockCycle * config.tCK * 1E-6; 
+		for (size_t i=0; i<config.NUM_CHANS; i++)
 		{
 			channels[i]->printStats(false); 
 		}
 		csvOut->finalize();
 	}
 	
-	for (size_t i=0; i<NUM_CHANS; i++)
+	if (syncQuantum > 0)
 	{
-		channels[i]->update(); 
+		if (pendingCycles == 0)
+		{
+			resetQueueBounds();
+		}
+		pendingCycles++;
+	}
+	else
+	{
+		for (size_t i=0; i<config.NUM_CHANS; i++)
+		{
+			channels[i]->update(); 
+		}
 	}
 
 
 	currentClockCycle++; 
+
+	if (syncQuantum > 0 && pendingCycles >= syncQuantum)
+	{
+		syncChannels();
+	}
 }
-unsigned MultiChannelMemorySystem::findChannelNumber(uint64_t addr)
+
+/*
+ * Runs each channel on its own thread. Instead of updating every channel on
+ * every cycle, update() just counts cycles and every syncQuantum cycles the
+ * channels catch up in parallel. Read/write callbacks for those cycles are
+ * then delivered in the same order (and with the same cycle numbers) as in
+ * serial mode, so the results don't change; the host just hears about them
+ * up to syncQuantum cycles late.
+ *
+ * Anything that has to look at the current state of a channel
+ * (willAcceptTransaction(), addTransaction(Transaction*), printStats(), ...)
+ * syncs first, so it sees exactly what it would have in serial mode. Adds
+ * don't have to, as long as the channel's queue can't be full yet (see
+ * ChannelWorker::queueBound); addTransaction(isWrite, addr) always accepts, so
+ * it never does. Syncs that cover only a few cycles run the channels one after
+ * the other, so a host that keeps the queues full, or checks isDrained() every
+ * cycle, gets little out of this; runUntilDrained() is the way to wait for the
+ * memory system to empty.
+ */
+void MultiChannelMemorySystem::enableParallelChannels(unsigned syncQuantum_)
 {
-	// Single channel case is a trivial shortcut case 
-	if (NUM_CHANS == 1)
+	if (syncQuantum_ == 0)
+	{
+		return;
+	}
+	if (syncQuantum > 0)
 	{
-		return 0; 
+		syncQuantum = syncQuantum_;
+		return;
+	}
+	// these write to shared streams from inside update()
+	if (config.DEBUG_TRANS_Q || config.DEBUG_CMD_Q || config.DEBUG_ADDR_MAP || config.DEBUG_BANKSTATE || config.DEBUG_BUS ||
+			config.DEBUG_BANKS || config.DEBUG_POWER || config.VERIFICATION_OUTPUT)
+	{
+		ERROR("Parallel channels can't be used with debug or verification output, staying serial");
+		return;
 	}
 
-	if (!isPowerOfTwo(NUM_CHANS))
+	syncQuantum = syncQuantum_;
+	for (size_t i=0; i<config.NUM_CHANS; i++)
+	{
+		ChannelWorker *worker = new ChannelWorker(this, i);
+		channels[i]->RegisterCallbacks(worker->readDone, worker->writeDone, MemorySystem::ReportPower);
+		workers.push_back(worker);
+	}
+	// channel 0 is run by whichever thread calls syncChannels()
+	for (size_t i=1; i<config.NUM_CHANS; i++)
+	{
+		workers[i]->seenGeneration = syncGeneration;
+		if (pthread_create(&workers[i]->thread, NULL, &MultiChannelMemorySystem::workerMain, workers[i]) != 0)
+		{
+			ERROR("Cannot create worker thread for channel "<<i);
+			abort();
+		}
+	}
+}
+
+void *MultiChannelMemorySystem::workerMain(void *arg)
+{
+	ChannelWorker *worker = (ChannelWorker *)arg;
+	MultiChannelMemorySystem *parent = worker->parent;
+
+	pthread_mutex_lock(&parent->syncLock);
+	while (true)
+	{
+		while (parent->syncGeneration == worker->seenGeneration && !parent->shuttingDown)
+		{
+			pthread_cond_wait(&parent->syncStart, &parent->syncLock);
+		}
+		if (parent->shuttingDown)
+		{
+			break;
+		}
+		worker->seenGeneration = parent->syncGeneration;
+		pthread_mutex_unlock(&parent->syncLock);
+
+		parent->runChannel(worker->channel);
+
+		pthread_mutex_lock(&parent->syncLock);
+		parent->workersRunning--;
+		if (parent->workersRunning == 0)
+		{
+			pthread_cond_signal(&parent->syncDone);
+		}
+	}
+	pthread_mutex_unlock(&parent->syncLock);
+	return NULL;
+}
+
+//updates a channel for the cycles its worker was asked to run, replaying the
+//transactions the host added along the way
+void MultiChannelMemorySystem::runChannel(unsigned chan)
+{
+	ChannelWorker *worker = workers[chan];
+	vector<ChannelWorker::PendingAdd> &adds = worker->pendingAdds;
+	size_t nextAdd = 0;
+	uint64_t cycle;
+	for (cycle=0; cycle<worker->cyclesToRun; cycle++)
+	{
+		while (nextAdd < adds.size() && adds[nextAdd].cycleOffset == cycle)
+		{
+			channels[chan]->acceptTransaction(adds[nextAdd].trans);
+			nextAdd++;
+		}
+		if (worker->stopWhenDrained && channels[chan]->isDrained())
+		{
+			break;
+		}
+		channels[chan]->update();
+	}
+	worker->cyclesRun = cycle;
+	// these were added after the last update()
+	for (; nextAdd < adds.size(); nextAdd++)
+	{
+		channels[chan]->acceptTransaction(adds[nextAdd].trans);
+	}
+	adds.clear();
+}
+
+//runs every channel's worker; maxCycles is the most any of them was asked for
+void MultiChannelMemorySystem::runChannels(uint64_t maxCycles)
+{
+	if (maxCycles < MIN_PARALLEL_CYCLES)
+	{
+		for (size_t i=0; i<config.NUM_CHANS; i++)
+		{
+			runChannel(i);
+		}
+		return;
+	}
+
+	pthread_mutex_lock(&syncLock);
+	workersRunning = config.NUM_CHANS-1;
+	syncGeneration++;
+	pthread_cond_broadcast(&syncStart);
+	pthread_mutex_unlock(&syncLock);
+
+	runChannel(0);
+
+	pthread_mutex_lock(&syncLock);
+	while (workersRunning > 0)
+	{
+		pthread_cond_wait(&syncDone, &syncLock);
+	}
+	pthread_mutex_unlock(&syncLock);
+}
+
+//simulates all the cycles that have elapsed since the last sync
+void MultiChannelMemorySystem::syncChannels()
+{
+	if (pendingCycles == 0)
+	{
+		return;
+	}
+
+	for (size_t i=0; i<config.NUM_CHANS; i++)
+	{
+		workers[i]->cyclesToRun = pendingCycles;
+		workers[i]->stopWhenDrained = false;
+	}
+	runChannels(pendingCycles);
+
+	pendingCycles = 0;
+	deliverCallbacks();
+}
+
+//the channels are in sync at the start of a quantum, so the bounds are exact
+void MultiChannelMemorySystem::resetQueueBounds()
+{
+	for (size_t i=0; i<config.NUM_CHANS; i++)
+	{
+		workers[i]->queueBound = channels[i]->memoryController->transactionQueue.size() +
+			channels[i]->pendingTransactions.size();
+	}
+}
+
+//hands the buffered callbacks to the host ordered by cycle and then by channel,
+//which is the order in which serial mode would have made them
+void MultiChannelMemorySystem::deliverCallbacks()
+{
+	vector<size_t> next(config.NUM_CHANS, 0);
+	while (true)
+	{
+		unsigned chan = config.NUM_CHANS;
+		for (unsigned i=0; i<config.NUM_CHANS; i++)
+		{
+			if (next[i] < workers[i]->completions.size() &&
+					(chan == config.NUM_CHANS || workers[i]->completions[next[i]].cycle < workers[chan]->completions[next[chan]].cycle))
+			{
+				chan = i;
+			}
+		}
+		if (chan == config.NUM_CHANS)
+		{
+			break;
+		}
+
+		const ChannelWorker::Completion &c = workers[chan]->completions[next[chan]];
+		TransactionCompleteCB *cb = c.isWrite ? hostWriteDone : hostReadDone;
+		if (cb != NULL)
+		{
+			(*cb)(chan, c.addr, c.cycle);
+		}
+		next[chan]++;
+	}
+	for (size_t i=0; i<config.NUM_CHANS; i++)
+	{
+		workers[i]->completions.clear();
+	}
+}
+/*
+ * Jumps over up to maxCycles DRAM cycles in which nothing can happen in any
+ * channel, producing the same stats as calling update() for each of them.
+ * Returns the number of cycles that were skipped (0 if something is going on
+ * in the memory system right now). The caller has to make sure that no
+ * transactions would have been added during the skipped cycles.
+ *
+ * Only supported with a 1:1 clock ratio, since otherwise a "cycle" means
+ * different things to the caller and to the memory system
+ */
+uint64_t MultiChannelMemorySystem::skipIdleCycles(uint64_t maxCycles)
+{
+	if (clockDomainCrosser.clock1 != clockDomainCrosser.clock2)
+	{
+		return 0;
+	}
+	syncChannels();
+
+	// the first update sets up the output files and each epoch boundary prints
+	// stats, so these cycles always go through update()
+	uint64_t cyclesIntoEpoch = currentClockCycle % config.EPOCH_LENGTH;
+	if (currentClockCycle == 0 || cyclesIntoEpoch == 0)
+	{
+		return 0;
+	}
+
+	uint64_t cycles = min(maxCycles, config.EPOCH_LENGTH - cyclesIntoEpoch);
+	for (size_t i=0; i<config.NUM_CHANS && cycles > 0; i++)
+	{
+		cycles = min(cycles, channels[i]->cyclesUntilNextEvent());
+	}
+
+	if (cycles > 0)
+	{
+		for (size_t i=0; i<config.NUM_CHANS; i++)
+		{
+			channels[i]->skipCycles(cycles);
+		}
+		currentClockCycle += cycles;
+	}
+	return cycles;
+}
+
+/*
+ * True once every transaction that has been added has completed (and had its
+ * callback made) in every channel. Refreshes and open rows don't count; they
+ * are just the memory system idling.
+ */
+bool MultiChannelMemorySystem::isDrained()
+{
+	syncChannels();
+	for (size_t i=0; i<config.NUM_CHANS; i++)
+	{
+		if (!channels[i]->isDrained())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Updates the memory system until isDrained(), but for no more than maxCycles
+ * cycles, and returns how many cycles that took. This is the same as calling
+ * isDrained() and update() in a loop, and the host can't add anything in the
+ * meantime.
+ *
+ * In parallel mode (with a 1:1 clock ratio) each channel runs on its own until
+ * it is drained, and then the ones that finished early are updated until the
+ * last one did. Once drained, a channel stays drained as long as nothing is
+ * added, so this stops on the same cycle the loop would have.
+ */
+uint64_t MultiChannelMemorySystem::runUntilDrained(uint64_t maxCycles)
+{
+	uint64_t cycles = 0;
+	while (cycles < maxCycles && !isDrained())
+	{
+		// the first update and each epoch boundary have to go through update()
+		uint64_t cyclesIntoEpoch = currentClockCycle % config.EPOCH_LENGTH;
+		uint64_t window = 0;
+		if (syncQuantum > 0 && clockDomainCrosser.clock1 == clockDomainCrosser.clock2 && cyclesIntoEpoch != 0)
+		{
+			window = min(maxCycles - cycles, config.EPOCH_LENGTH - cyclesIntoEpoch);
+		}
+		if (window < MIN_PARALLEL_CYCLES)
+		{
+			update();
+			cycles++;
+			continue;
+		}
+
+		for (size_t i=0; i<config.NUM_CHANS; i++)
+		{
+			workers[i]->cyclesToRun = window;
+			workers[i]->stopWhenDrained = true;
+		}
+		runChannels(window);
+
+		uint64_t drainedAfter = 0;
+		for (size_t i=0; i<config.NUM_CHANS; i++)
+		{
+			drainedAfter = max(drainedAfter, workers[i]->cyclesRun);
+		}
+		uint64_t catchUp = 0;
+		for (size_t i=0; i<config.NUM_CHANS; i++)
+		{
+			workers[i]->cyclesToRun = drainedAfter - workers[i]->cyclesRun;
+			workers[i]->stopWhenDrained = false;
+			catchUp = max(catchUp, workers[i]->cyclesToRun);
+		}
+		runChannels(catchUp);
+
+		currentClockCycle += drainedAfter;
+		cycles += drainedAfter;
+		deliverCallbacks();
+	}
+	return cycles;
+}
+
+//maps the address of a transaction entering the memory system; this is the
+//only place it gets decoded, everything downstream uses the stored coordinates
+unsigned MultiChannelMemorySystem::findChannelNumber(Transaction *trans)
+{
+	if (!isPowerOfTwo(config.NUM_CHANS))
 	{
 		ERROR("We can only support power of two # of channels.\n" <<
 				"I don't know what Intel was thinking, but trying to address map half a bit is a neat trick that we're not sure how to do"); 
 		abort(); 
 	}
 
-	// only chan is used from this set 
-	unsigned channelNumber,rank,bank,row,col;
-	addressMapping(addr, channelNumber, rank, bank, row, col); 
-	if (channelNumber >= NUM_CHANS)
+	trans->mapAddress(config);
+	unsigned channelNumber = trans->channel;
+	if (channelNumber >= config.NUM_CHANS)
 	{
-		ERROR("Got channel index "<<channelNumber<<" but only "<<NUM_CHANS<<" exist"); 
+		ERROR("Got channel index "<<channelNumber<<" but only "<<config.NUM_CHANS<<" exist"); 
 		abort();
 	}
 	//DEBUG("Channel idx = "<<channelNumber<<" totalbits="<<totalBits<<" channelbits="<<channelBits); 
@@ -429,6 +950,10 @@ ostream &MultiChannelMemorySystem::getLogFile()
 {
 	return dramsim_log; 
 }
+const Config &MultiChannelMemorySystem::getConfig() const
+{
+	return config;
+}
 bool MultiChannelMemorySystem::addTransaction(const Transaction &trans)
 {
 	// copy the transaction and send the pointer to the new transaction 
@@ -437,14 +962,48 @@ bool MultiChannelMemorySystem::addTransaction(const Transaction &trans)
 
 bool MultiChannelMemorySystem::addTransaction(Transaction *trans)
 {
-	unsigned channelNumber = findChannelNumber(trans->address); 
-	return channels[channelNumber]->addTransaction(trans); 
+	unsigned channelNumber = findChannelNumber(trans); 
+	// in parallel mode, an add that is sure to be accepted can wait to be
+	// replayed until the channel catches up; otherwise it has to find out
+	if (pendingCycles > 0)
+	{
+		if (deferTransaction(channelNumber, trans))
+		{
+			return true;
+		}
+		syncChannels();
+	}
+	return channels[channelNumber]->addMappedTransaction(trans); 
 }
 
 bool MultiChannelMemorySystem::addTransaction(bool isWrite, uint64_t addr)
 {
-	unsigned channelNumber = findChannelNumber(addr); 
-	return channels[channelNumber]->addTransaction(isWrite, addr); 
+	Transaction *trans = new Transaction(isWrite ? DATA_WRITE : DATA_READ, addr, NULL);
+	unsigned channelNumber = findChannelNumber(trans); 
+	// this always accepts, so in parallel mode it can wait to be replayed
+	// until the channel catches up
+	if (pendingCycles > 0)
+	{
+		ChannelWorker::PendingAdd add = {pendingCycles, trans};
+		workers[channelNumber]->pendingAdds.push_back(add);
+		workers[channelNumber]->queueBound++;
+		return true;
+	}
+	return channels[channelNumber]->acceptTransaction(trans); 
+}
+
+//queues an add for replay if the channel is sure to accept it at this cycle
+bool MultiChannelMemorySystem::deferTransaction(unsigned chan, Transaction *trans)
+{
+	ChannelWorker *worker = workers[chan];
+	if (worker->queueBound >= config.TRANS_QUEUE_DEPTH)
+	{
+		return false;
+	}
+	ChannelWorker::PendingAdd add = {pendingCycles, trans};
+	worker->pendingAdds.push_back(add);
+	worker->queueBound++;
+	return true;
 }
 
 /*
@@ -459,13 +1018,31 @@ bool MultiChannelMemorySystem::addTransaction(bool isWrite, uint64_t addr)
 bool MultiChannelMemorySystem::willAcceptTransaction(uint64_t addr)
 {
 	unsigned chan, rank,bank,row,col; 
-	addressMapping(addr, chan, rank, bank, row, col); 
+	addressMapping(config, addr, chan, rank, bank, row, col); 
+	if (pendingCycles > 0 && workers[chan]->queueBound < config.TRANS_QUEUE_DEPTH)
+	{
+		return true;
+	}
+	syncChannels();
 	return channels[chan]->WillAcceptTransaction(); 
 }
 
 bool MultiChannelMemorySystem::willAcceptTransaction()
 {
-	for (size_t c=0; c<NUM_CHANS; c++) {
+	if (pendingCycles > 0)
+	{
+		bool sure = true;
+		for (size_t c=0; c<config.NUM_CHANS; c++)
+		{
+			sure = sure && workers[c]->queueBound < config.TRANS_QUEUE_DEPTH;
+		}
+		if (sure)
+		{
+			return true;
+		}
+	}
+	syncChannels();
+	for (size_t c=0; c<config.NUM_CHANS; c++) {
 		if (!channels[c]->WillAcceptTransaction())
 		{
 			return false; 
@@ -477,14 +1054,30 @@ bool MultiChannelMemorySystem::willAcceptTransaction()
 
 
 void MultiChannelMemorySystem::printStats(bool finalStats) {
+	syncChannels();
 
-	(*csvOut) << "ms" <<currentClockCycle * tCK * 1E-6; 
-	for (size_t i=0; i<NUM_CHANS; i++)
+	(*csvOut) << "ms" <<currentClockCycle * config.tCK * 1E-6; 
+	for (size_t i=0; i<config.NUM_CHANS; i++)
 	{
 		PRINT("==== Channel ["<<i<<"] ====");
 		channels[i]->printStats(finalStats); 
 		PRINT("//// Channel ["<<i<<"] ////");
 	}
+	if (finalStats)
+	{
+		PoolStats transactionStats = {0, 0};
+		PoolStats busPacketStats = {0, 0};
+		for (size_t i=0; i<config.NUM_CHANS; i++)
+		{
+			transactionStats.allocations += channels[i]->transactionAllocations.allocations;
+			transactionStats.heapAllocations += channels[i]->transactionAllocations.heapAllocations;
+			busPacketStats.allocations += channels[i]->busPacketAllocations.allocations;
+			busPacketStats.heapAllocations += channels[i]->busPacketAllocations.heapAllocations;
+		}
+		PRINT(" == Allocations");
+		PRINT("   Transactions : "<<transactionStats.allocations<<" ("<<transactionStats.heapAllocations<<" from the heap)");
+		PRINT("   Bus packets  : "<<busPacketStats.allocations<<" ("<<busPacketStats.heapAllocations<<" from the heap)");
+	}
 	csvOut->finalize();
 }
 void MultiChannelMemorySystem::RegisterCallbacks( 
@@ -492,9 +1085,20 @@ void MultiChannelMemorySystem::RegisterCallbacks(
 		TransactionCompleteCB *writeDone,
 		void (*reportPower)(double bgpower, double burstpower, double refreshpower, double actprepower))
 {
-	for (size_t i=0; i<NUM_CHANS; i++)
+	// flush anything buffered for the old callbacks first
+	syncChannels();
+	hostReadDone = readDone;
+	hostWriteDone = writeDone;
+	for (size_t i=0; i<config.NUM_CHANS; i++)
 	{
-		channels[i]->RegisterCallbacks(readDone, writeDone, reportPower); 
+		if (syncQuantum > 0)
+		{
+			channels[i]->RegisterCallbacks(workers[i]->readDone, workers[i]->writeDone, reportPower); 
+		}
+		else
+		{
+			channels[i]->RegisterCallbacks(readDone, writeDone, reportPower); 
+		}
 	}
 }
 
@@ -505,30 +1109,30 @@ void MultiChannelMemorySystem::RegisterCallbacks(
  */
 int MultiChannelMemorySystem::getIniBool(const std::string& field, bool *val)
 {
-	if (!IniReader::CheckIfAllSet())
+	if (!iniReader.CheckIfAllSet())
 		exit(-1);
-	return IniReader::getBool(field, val);
+	return iniReader.getBool(field, val);
 }
 
 int MultiChannelMemorySystem::getIniUint(const std::string& field, unsigned int *val)
 {
-	if (!IniReader::CheckIfAllSet())
+	if (!iniReader.CheckIfAllSet())
 		exit(-1);
-	return IniReader::getUint(field, val);
+	return iniReader.getUint(field, val);
 }
 
 int MultiChannelMemorySystem::getIniUint64(const std::string& field, uint64_t *val)
 {
-	if (!IniReader::CheckIfAllSet())
+	if (!iniReader.CheckIfAllSet())
 		exit(-1);
-	return IniReader::getUint64(field, val);
+	return iniReader.getUint64(field, val);
 }
 
 int MultiChannelMemorySystem::getIniFloat(const std::string& field, float *val)
 {
-	if (!IniReader::CheckIfAllSet())
+	if (!iniReader.CheckIfAllSet())
 		exit(-1);
-	return IniReader::getFloat(field, val);
+	return iniReader.getFloat(field, val);
 }
 
 namespace DRAMSim {
@@ -34,6 +34,7 @@
 #include "IniReader.h"
 #include "ClockDomain.h"
 #include "CSVWriter.h"
+#include <pthread.h>
 
 
 namespace DRAMSim {
@@ -51,8 +52,12 @@ class MultiChannelMemorySystem : public SimulatorObject
 			bool willAcceptTransaction(); 
 			bool willAcceptTransaction(uint64_t addr); 
 			void update();
+			uint64_t skipIdleCycles(uint64_t maxCycles);
+			bool isDrained();
+			uint64_t runUntilDrained(uint64_t maxCycles);
 			void printStats(bool finalStats=false);
 			ostream &getLogFile();
+			const Config &getConfig() const;
 			void RegisterCallbacks( 
 				TransactionCompleteCB *readDone,
 				TransactionCompleteCB *writeDone,
@@ -64,15 +69,18 @@ class MultiChannelMemorySystem : public SimulatorObject
 
 	void InitOutputFiles(string tracefilename);
 	void setCPUClockSpeed(uint64_t cpuClkFreqHz);
+	void enableParallelChannels(unsigned syncQuantum);
 
 	//output file
 	std::ofstream visDataOut;
 	ofstream dramsim_log; 
 
 	private:
-		unsigned findChannelNumber(uint64_t addr);
+		unsigned findChannelNumber(Transaction *trans);
 		void actual_update(); 
 		vector<MemorySystem*> channels; 
+		Config config;
+		IniReader iniReader;
 		unsigned megsOfMemory; 
 		string deviceIniFilename;
 		string systemIniFilename;
@@ -84,6 +92,26 @@ class MultiChannelMemorySystem : public SimulatorObject
 		static bool fileExists(string path); 
 		CSVWriter *csvOut; 
 
+		// parallel channel mode (see enableParallelChannels())
+		struct ChannelWorker;
+		static void *workerMain(void *arg);
+		void runChannel(unsigned chan);
+		void runChannels(uint64_t maxCycles);
+		void syncChannels();
+		void resetQueueBounds();
+		bool deferTransaction(unsigned chan, Transaction *trans);
+		void deliverCallbacks();
+		vector<ChannelWorker *> workers;
+		unsigned syncQuantum; // 0 means channels are updated serially every cycle
+		unsigned pendingCycles; // cycles that have elapsed but haven't been simulated yet
+		TransactionCompleteCB *hostReadDone;
+		TransactionCompleteCB *hostWriteDone;
+		pthread_mutex_t syncLock;
+		pthread_cond_t syncStart;
+		pthread_cond_t syncDone;
+		unsigned syncGeneration;
+		unsigned workersRunning;
+		bool shuttingDown;
 
 	};
 }
@@ -0,0 +1,148 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+//ObjectPool.h
+//
+//Freelist allocator for the objects that are created and destroyed for every
+//request (transactions and bus packets)
+//
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <new>
+
+//objects beyond this many are handed back to the heap instead of being kept
+#define OBJECT_POOL_MAX_FREE 65536
+
+namespace DRAMSim
+{
+struct PoolStats
+{
+	uint64_t allocations; // every object handed out
+	uint64_t heapAllocations; // the ones that weren't on a freelist
+};
+
+/*
+ * Each thread keeps its own freelist per type, so allocating and freeing never
+ * takes a lock. When channels run in parallel each channel's worker thread has
+ * its own lists; in serial mode all channels share the ones of the thread
+ * driving them. An object freed on another thread than the one that allocated
+ * it just joins the freeing thread's list, which is why the lists are capped.
+ *
+ * The pool doesn't keep any counters itself: whoever allocates can pass the
+ * PoolStats it wants the allocation counted in (see the placement forms of
+ * Transaction's and BusPacket's operator new).
+ */
+template <typename T>
+class ObjectPool
+{
+	struct FreeObject
+	{
+		FreeObject *next;
+	};
+
+	struct ThreadPool
+	{
+		FreeObject *head;
+		size_t length;
+
+		ThreadPool() : head(NULL), length(0)
+		{
+		}
+		~ThreadPool()
+		{
+			while (head)
+			{
+				FreeObject *object = head;
+				head = head->next;
+				free(object);
+			}
+		}
+	};
+
+	static thread_local ThreadPool local;
+
+public:
+	//size is what operator new was asked for; the freelists only hold objects
+	//	of exactly sizeof(T), so a class derived from T needs its own operator new
+	static void *allocate(size_t size, PoolStats *stats = NULL)
+	{
+		assert(size == sizeof(T));
+		ThreadPool &pool = local;
+		if (stats)
+		{
+			stats->allocations++;
+		}
+		if (pool.head)
+		{
+			FreeObject *object = pool.head;
+			pool.head = object->next;
+			pool.length--;
+			return object;
+		}
+		if (stats)
+		{
+			stats->heapAllocations++;
+		}
+		void *object = malloc(sizeof(T) < sizeof(FreeObject) ? sizeof(FreeObject) : sizeof(T));
+		if (!object)
+		{
+			throw std::bad_alloc();
+		}
+		return object;
+	}
+
+	static void release(void *p)
+	{
+		if (!p)
+		{
+			return;
+		}
+		ThreadPool &pool = local;
+		if (pool.length >= OBJECT_POOL_MAX_FREE)
+		{
+			free(p);
+			return;
+		}
+		FreeObject *object = (FreeObject *)p;
+		object->next = pool.head;
+		pool.head = object;
+		pool.length++;
+	}
+};
+
+template <typename T> thread_local typename ObjectPool<T>::ThreadPool ObjectPool<T>::local;
+}
+
+#endif
@@ -37,14 +37,14 @@
 using namespace std;
 using namespace DRAMSim;
 
-Rank::Rank(ostream &dramsim_log_) :
+Rank::Rank(const Config &config_, ostream &dramsim_log_) :
 	id(-1),
+	config(config_),
 	dramsim_log(dramsim_log_),
 	isPowerDown(false),
 	refreshWaiting(false),
-	readReturnCountdown(0),
-	banks(NUM_BANKS, Bank(dramsim_log_)),
-	bankStates(NUM_BANKS, BankState(dramsim_log_))
+	banks(config_.NUM_BANKS, Bank(config_, dramsim_log_)),
+	bankStates(config_, 1)
 
 {
 
@@ -79,190 +79,183 @@ Rank::~Rank()
 	readReturnPacket.clear(); 
 	delete outgoingDataPacket; 
 }
-void Rank::receiveFromBus(BusPacket *packet)
+/*
+ * The rank's own copy of the bank states, used to double check that the
+ * controller only sends commands that are allowed. This duplicates all of the
+ * controller's timing bookkeeping, so it is skipped with TRUST_CONTROLLER.
+ */
+void Rank::checkCommand(BusPacket *packet)
 {
-	if (DEBUG_BUS)
-	{
-		PRINTN(" -- R" << this->id << " Receiving On Bus    : ");
-		packet->print();
-	}
-	if (VERIFICATION_OUTPUT)
-	{
-		packet->print(currentClockCycle,false);
-	}
-
 	switch (packet->busPacketType)
 	{
 	case READ:
 		//make sure a read is allowed
-		if (bankStates[packet->bank].currentBankState != RowActive ||
-		        currentClockCycle < bankStates[packet->bank].nextRead ||
-		        packet->row != bankStates[packet->bank].openRowAddress)
+		if (bankStates.state(0, packet->bank).currentBankState != RowActive ||
+		        currentClockCycle < bankStates.earliestRead(0, packet->bank) ||
+		        packet->row != bankStates.state(0, packet->bank).openRowAddress)
 		{
-			packet->print();
+			packet->print(dramsim_log);
 			ERROR("== Error - Rank " << id << " received a READ when not allowed");
 			exit(0);
 		}
 
 		//update state table
-		bankStates[packet->bank].nextPrecharge = max(bankStates[packet->bank].nextPrecharge, currentClockCycle + READ_TO_PRE_DELAY);
-		for (size_t i=0;i<NUM_BANKS;i++)
-		{
-			bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + max(tCCD, BL/2));
-			bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + READ_TO_WRITE_DELAY);
-		}
-
-		//get the read data and put it in the storage which delays until the appropriate time (RL)
-#ifndef NO_STORAGE
-		banks[packet->bank].read(packet);
-#else
-		packet->busPacketType = DATA;
-#endif
-		readReturnPacket.push_back(packet);
-		readReturnCountdown.push_back(RL);
+		bankStates.nextPrecharge(0, packet->bank) = max(bankStates.nextPrecharge(0, packet->bank), currentClockCycle + config.READ_TO_PRE_DELAY());
+		bankStates.readIssued(0, currentClockCycle);
 		break;
 	case READ_P:
 		//make sure a read is allowed
-		if (bankStates[packet->bank].currentBankState != RowActive ||
-		        currentClockCycle < bankStates[packet->bank].nextRead ||
-		        packet->row != bankStates[packet->bank].openRowAddress)
+		if (bankStates.state(0, packet->bank).currentBankState != RowActive ||
+		        currentClockCycle < bankStates.earliestRead(0, packet->bank) ||
+		        packet->row != bankStates.state(0, packet->bank).openRowAddress)
 		{
 			ERROR("== Error - Rank " << id << " received a READ_P when not allowed");
 			exit(-1);
 		}
 
 		//update state table
-		bankStates[packet->bank].currentBankState = Idle;
-		bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + READ_AUTOPRE_DELAY);
-		for (size_t i=0;i<NUM_BANKS;i++)
-		{
-			//will set next read/write for all banks - including current (which shouldnt matter since its now idle)
-			bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + max(BL/2, tCCD));
-			bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + READ_TO_WRITE_DELAY);
-		}
-
-		//get the read data and put it in the storage which delays until the appropriate time (RL)
-#ifndef NO_STORAGE
-		banks[packet->bank].read(packet);
-#else
-		packet->busPacketType = DATA;
-#endif
-
-		readReturnPacket.push_back(packet);
-		readReturnCountdown.push_back(RL);
+		bankStates.state(0, packet->bank).currentBankState = Idle;
+		bankStates.nextActivate(0, packet->bank) = max(bankStates.nextActivate(0, packet->bank), currentClockCycle + config.READ_AUTOPRE_DELAY());
+		bankStates.readIssued(0, currentClockCycle);
 		break;
 	case WRITE:
 		//make sure a write is allowed
-		if (bankStates[packet->bank].currentBankState != RowActive ||
-		        currentClockCycle < bankStates[packet->bank].nextWrite ||
-		        packet->row != bankStates[packet->bank].openRowAddress)
+		if (bankStates.state(0, packet->bank).currentBankState != RowActive ||
+		        currentClockCycle < bankStates.earliestWrite(0, packet->bank) ||
+		        packet->row != bankStates.state(0, packet->bank).openRowAddress)
 		{
 			ERROR("== Error - Rank " << id << " received a WRITE when not allowed");
-			bankStates[packet->bank].print();
+			bankStates.print(0, packet->bank, dramsim_log);
 			exit(0);
 		}
 
 		//update state table
-		bankStates[packet->bank].nextPrecharge = max(bankStates[packet->bank].nextPrecharge, currentClockCycle + WRITE_TO_PRE_DELAY);
-		for (size_t i=0;i<NUM_BANKS;i++)
-		{
-			bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + WRITE_TO_READ_DELAY_B);
-			bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(BL/2, tCCD));
-		}
-
-		//take note of where data is going when it arrives
-		incomingWriteBank = packet->bank;
-		incomingWriteRow = packet->row;
-		incomingWriteColumn = packet->column;
-		delete(packet);
+		bankStates.nextPrecharge(0, packet->bank) = max(bankStates.nextPrecharge(0, packet->bank), currentClockCycle + config.WRITE_TO_PRE_DELAY());
+		bankStates.writeIssued(0, currentClockCycle);
 		break;
 	case WRITE_P:
 		//make sure a write is allowed
-		if (bankStates[packet->bank].currentBankState != RowActive ||
-		        currentClockCycle < bankStates[packet->bank].nextWrite ||
-		        packet->row != bankStates[packet->bank].openRowAddress)
+		if (bankStates.state(0, packet->bank).currentBankState != RowActive ||
+		        currentClockCycle < bankStates.earliestWrite(0, packet->bank) ||
+		        packet->row != bankStates.state(0, packet->bank).openRowAddress)
 		{
 			ERROR("== Error - Rank " << id << " received a WRITE_P when not allowed");
 			exit(0);
 		}
 
 		//update state table
-		bankStates[packet->bank].currentBankState = Idle;
-		bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + WRITE_AUTOPRE_DELAY);
-		for (size_t i=0;i<NUM_BANKS;i++)
-		{
-			bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(tCCD, BL/2));
-			bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + WRITE_TO_READ_DELAY_B);
-		}
-
-		//take note of where data is going when it arrives
-		incomingWriteBank = packet->bank;
-		incomingWriteRow = packet->row;
-		incomingWriteColumn = packet->column;
-		delete(packet);
+		bankStates.state(0, packet->bank).currentBankState = Idle;
+		bankStates.nextActivate(0, packet->bank) = max(bankStates.nextActivate(0, packet->bank), currentClockCycle + config.WRITE_AUTOPRE_DELAY());
+		bankStates.writeIssued(0, currentClockCycle);
 		break;
 	case ACTIVATE:
 		//make sure activate is allowed
-		if (bankStates[packet->bank].currentBankState != Idle ||
-		        currentClockCycle < bankStates[packet->bank].nextActivate)
+		if (bankStates.state(0, packet->bank).currentBankState != Idle ||
+		        currentClockCycle < bankStates.nextActivate(0, packet->bank))
 		{
 			ERROR("== Error - Rank " << id << " received an ACT when not allowed");
-			packet->print();
-			bankStates[packet->bank].print();
+			packet->print(dramsim_log);
+			bankStates.print(0, packet->bank, dramsim_log);
 			exit(0);
 		}
 
-		bankStates[packet->bank].currentBankState = RowActive;
-		bankStates[packet->bank].nextActivate = currentClockCycle + tRC;
-		bankStates[packet->bank].openRowAddress = packet->row;
+		bankStates.state(0, packet->bank).currentBankState = RowActive;
+		bankStates.nextActivate(0, packet->bank) = currentClockCycle + config.tRC;
+		bankStates.state(0, packet->bank).openRowAddress = packet->row;
 
 		//if AL is greater than one, then posted-cas is enabled - handle accordingly
-		if (AL>0)
+		if (config.AL>0)
 		{
-			bankStates[packet->bank].nextWrite = currentClockCycle + (tRCD-AL);
-			bankStates[packet->bank].nextRead = currentClockCycle + (tRCD-AL);
+			bankStates.nextWrite(0, packet->bank) = currentClockCycle + (config.tRCD-config.AL);
+			bankStates.nextRead(0, packet->bank) = currentClockCycle + (config.tRCD-config.AL);
 		}
 		else
 		{
-			bankStates[packet->bank].nextWrite = currentClockCycle + (tRCD-AL);
-			bankStates[packet->bank].nextRead = currentClockCycle + (tRCD-AL);
+			bankStates.nextWrite(0, packet->bank) = currentClockCycle + (config.tRCD-config.AL);
+			bankStates.nextRead(0, packet->bank) = currentClockCycle + (config.tRCD-config.AL);
 		}
 
-		bankStates[packet->bank].nextPrecharge = currentClockCycle + tRAS;
-		for (size_t i=0;i<NUM_BANKS;i++)
+		bankStates.nextPrecharge(0, packet->bank) = currentClockCycle + config.tRAS;
+		for (size_t i=0;i<config.NUM_BANKS;i++)
 		{
 			if (i != packet->bank)
 			{
-				bankStates[i].nextActivate = max(bankStates[i].nextActivate, currentClockCycle + tRRD);
+				bankStates.nextActivate(0, i) = max(bankStates.nextActivate(0, i), currentClockCycle + config.tRRD);
 			}
 		}
-		delete(packet); 
 		break;
 	case PRECHARGE:
 		//make sure precharge is allowed
-		if (bankStates[packet->bank].currentBankState != RowActive ||
-		        currentClockCycle < bankStates[packet->bank].nextPrecharge)
+		if (bankStates.state(0, packet->bank).currentBankState != RowActive ||
+		        currentClockCycle < bankStates.nextPrecharge(0, packet->bank))
 		{
 			ERROR("== Error - Rank " << id << " received a PRE when not allowed");
 			exit(0);
 		}
 
-		bankStates[packet->bank].currentBankState = Idle;
-		bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + tRP);
-		delete(packet); 
+		bankStates.state(0, packet->bank).currentBankState = Idle;
+		bankStates.nextActivate(0, packet->bank) = max(bankStates.nextActivate(0, packet->bank), currentClockCycle + config.tRP);
 		break;
 	case REFRESH:
-		refreshWaiting = false;
-		for (size_t i=0;i<NUM_BANKS;i++)
+		for (size_t i=0;i<config.NUM_BANKS;i++)
 		{
-			if (bankStates[i].currentBankState != Idle)
+			if (bankStates.state(0, i).currentBankState != Idle)
 			{
 				ERROR("== Error - Rank " << id << " received a REF when not allowed");
 				exit(0);
 			}
-			bankStates[i].nextActivate = currentClockCycle + tRFC;
+			bankStates.nextActivate(0, i) = currentClockCycle + config.tRFC;
 		}
-		delete(packet); 
+		break;
+	default:
+		break;
+	}
+}
+
+void Rank::receiveFromBus(BusPacket *packet)
+{
+	if (config.DEBUG_BUS)
+	{
+		PRINTN(" -- R" << this->id << " Receiving On Bus    : ");
+		packet->print(dramsim_log);
+	}
+	if (config.VERIFICATION_OUTPUT)
+	{
+		packet->print(currentClockCycle,false);
+	}
+	if (!config.TRUST_CONTROLLER)
+	{
+		checkCommand(packet);
+	}
+
+	switch (packet->busPacketType)
+	{
+	case READ:
+	case READ_P:
+		//get the read data and put it in the storage which delays until the appropriate time (RL)
+#ifndef NO_STORAGE
+		banks[packet->bank].read(packet);
+#else
+		packet->busPacketType = DATA;
+#endif
+		readReturnPacket.push_back(packet);
+		readReturnTime.push_back(currentClockCycle + config.RL());
+		break;
+	case WRITE:
+	case WRITE_P:
+		//take note of where data is going when it arrives
+		incomingWriteBank = packet->bank;
+		incomingWriteRow = packet->row;
+		incomingWriteColumn = packet->column;
+		delete(packet);
+		break;
+	case ACTIVATE:
+	case PRECHARGE:
+		delete(packet);
+		break;
+	case REFRESH:
+		refreshWaiting = false;
+		delete(packet);
 		break;
 	case DATA:
 		// TODO: replace this check with something that works?
@@ -272,8 +265,8 @@ void Rank::receiveFromBus(BusPacket *packet)
 			 packet->column != incomingWriteColumn)
 			{
 				cout << "== Error - Rank " << id << " received a DATA packet to the wrong place" << endl;
-				packet->print();
-				bankStates[packet->bank].print();
+				packet->print(dramsim_log);
+				bankStates.print(0, packet->bank, dramsim_log);
 				exit(0);
 			}
 		*/
@@ -312,49 +305,51 @@ void Rank::update()
 		}
 	}
 
-	// decrement the counter for all packets waiting to be sent back
-	for (size_t i=0;i<readReturnCountdown.size();i++)
-	{
-		readReturnCountdown[i]--;
-	}
-
-
-	if (readReturnCountdown.size() > 0 && readReturnCountdown[0]==0)
+	if (readReturnTime.size() > 0 && readReturnTime.front() <= currentClockCycle)
 	{
 		// RL time has passed since the read was issued; this packet is
 		// ready to go out on the bus
 
-		outgoingDataPacket = readReturnPacket[0];
-		dataCyclesLeft = BL/2;
+		outgoingDataPacket = readReturnPacket.front();
+		dataCyclesLeft = config.BL/2;
 
 		// remove the packet from the ranks
-		readReturnPacket.erase(readReturnPacket.begin());
-		readReturnCountdown.erase(readReturnCountdown.begin());
+		readReturnPacket.pop_front();
+		readReturnTime.pop_front();
 
-		if (DEBUG_BUS)
+		if (config.DEBUG_BUS)
 		{
 			PRINTN(" -- R" << this->id << " Issuing On Data Bus : ");
-			outgoingDataPacket->print();
+			outgoingDataPacket->print(dramsim_log);
 			PRINT("");
 		}
 
 	}
 }
 
+//true if there is no read data waiting to go out or currently on the bus
+bool Rank::isIdle() const
+{
+	return outgoingDataPacket == NULL && readReturnPacket.empty();
+}
+
 //power down the rank
 void Rank::powerDown()
 {
 	//perform checks
-	for (size_t i=0;i<NUM_BANKS;i++)
+	if (!config.TRUST_CONTROLLER)
 	{
-		if (bankStates[i].currentBankState != Idle)
+		for (size_t i=0;i<config.NUM_BANKS;i++)
 		{
-			ERROR("== Error - Trying to power down rank " << id << " while not all banks are idle");
-			exit(0);
-		}
+			if (bankStates.state(0, i).currentBankState != Idle)
+			{
+				ERROR("== Error - Trying to power down rank " << id << " while not all banks are idle");
+				exit(0);
+			}
 
-		bankStates[i].nextPowerUp = currentClockCycle + tCKE;
-		bankStates[i].currentBankState = PowerDown;
+			bankStates.state(0, i).nextPowerUp = currentClockCycle + config.tCKE;
+			bankStates.state(0, i).currentBankState = PowerDown;
+		}
 	}
 
 	isPowerDown = true;
@@ -371,15 +366,18 @@ void Rank::powerUp()
 
 	isPowerDown = false;
 
-	for (size_t i=0;i<NUM_BANKS;i++)
+	if (!config.TRUST_CONTROLLER)
 	{
-		if (bankStates[i].nextPowerUp > currentClockCycle)
+		for (size_t i=0;i<config.NUM_BANKS;i++)
 		{
-			ERROR("== Error - Trying to power up rank " << id << " before we're allowed to");
-			ERROR(bankStates[i].nextPowerUp << "    " << currentClockCycle);
-			exit(0);
+			if (bankStates.state(0, i).nextPowerUp > currentClockCycle)
+			{
+				ERROR("== Error - Trying to power up rank " << id << " before we're allowed to");
+				ERROR(bankStates.state(0, i).nextPowerUp << "    " << currentClockCycle);
+				exit(0);
+			}
+			bankStates.nextActivate(0, i) = currentClockCycle + config.tXP;
+			bankStates.state(0, i).currentBankState = Idle;
 		}
-		bankStates[i].nextActivate = currentClockCycle + tXP;
-		bankStates[i].currentBankState = Idle;
 	}
 }
@@ -39,6 +39,7 @@
 #include "SystemConfiguration.h"
 #include "Bank.h"
 #include "BankState.h"
+#include <deque>
 
 using namespace std;
 using namespace DRAMSim;
@@ -50,15 +51,18 @@ class Rank : public SimulatorObject
 {
 private:
 	int id;
+	const Config &config;
 	ostream &dramsim_log; 
 	unsigned incomingWriteBank;
 	unsigned incomingWriteRow;
 	unsigned incomingWriteColumn;
 	bool isPowerDown;
 
+	void checkCommand(BusPacket *packet);
+
 public:
 	//functions
-	Rank(ostream &dramsim_log_);
+	Rank(const Config &config_, ostream &dramsim_log_);
 	virtual ~Rank(); 
 	void receiveFromBus(BusPacket *packet);
 	void attachMemoryController(MemoryController *mc);
@@ -67,6 +71,7 @@ public:
 	void update();
 	void powerUp();
 	void powerDown();
+	bool isIdle() const;
 
 	//fields
 	MemoryController *memoryController;
@@ -74,11 +79,12 @@ public:
 	unsigned dataCyclesLeft;
 	bool refreshWaiting;
 
-	//these are vectors so that each element is per-bank
-	vector<BusPacket *> readReturnPacket;
-	vector<unsigned> readReturnCountdown;
+	//read data waiting for RL to pass along with the cycle it goes out on the bus;
+	//since RL is fixed these are always in order
+	deque<BusPacket *> readReturnPacket;
+	deque<uint64_t> readReturnTime;
 	vector<Bank> banks;
-	vector<BankState> bankStates;
+	BankStateTable bankStates;
 
 };
 }
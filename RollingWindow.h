@@ -0,0 +1,90 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef ROLLINGWINDOW_H
+#define ROLLINGWINDOW_H
+
+//RollingWindow.h
+//
+//Limits how many events may happen within any window of a given number of
+//cycles, e.g. at most four activates to a rank per tFAW
+//
+
+#include <stdint.h>
+#include <vector>
+
+namespace DRAMSim
+{
+/*
+ * Keeps the cycles of the last maxEvents events in a ring. Another event fits
+ * as long as fewer than maxEvents have happened so far or the oldest of the
+ * ones kept has left the window, so checking costs one comparison and nothing
+ * has to be done as cycles pass. Limits that only differ in the number of
+ * events or the window length (more activates per window, or windows spanning
+ * several ranks) are just other instances.
+ */
+class RollingWindow
+{
+public:
+	RollingWindow(unsigned maxEvents_, unsigned windowLength_) :
+		times(maxEvents_, 0),
+		next(0),
+		count(0),
+		windowLength(windowLength_)
+	{}
+
+	bool allows(uint64_t cycle) const
+	{
+		return count < times.size() || times[next] + windowLength <= cycle;
+	}
+
+	void record(uint64_t cycle)
+	{
+		//once the ring is full, next is also the oldest event
+		times[next] = cycle;
+		if (++next == times.size())
+		{
+			next = 0;
+		}
+		if (count < times.size())
+		{
+			count++;
+		}
+	}
+
+private:
+	std::vector<uint64_t> times;
+	size_t next;
+	size_t count;
+	unsigned windowLength;
+};
+}
+
+#endif
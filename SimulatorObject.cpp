@@ -51,4 +51,9 @@ void SimulatorObject::step()
 	currentClockCycle++;
 }
 
+void SimulatorObject::step(uint64_t cycles)
+{
+	currentClockCycle += cycles;
+}
+
 
@@ -53,6 +53,7 @@ public:
 	uint64_t currentClockCycle;
 
 	void step();
+	void step(uint64_t cycles);
 	virtual void update()=0;
 };
 }
@@ -0,0 +1,499 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//SweepSim.cpp
+//
+//Runs one trace against every combination of a set of parameter values,
+//parsing the trace only once and simulating the configurations in parallel
+//
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <getopt.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <map>
+#include <deque>
+
+#include "SystemConfiguration.h"
+#include "MultiChannelMemorySystem.h"
+#include "Transaction.h"
+#include "IniReader.h"
+#include "TraceReader.h"
+
+
+using namespace DRAMSim;
+using namespace std;
+
+// the simulations run concurrently, so their output would just be interleaved
+int SHOW_SIM_OUTPUT = 0;
+
+//one line of the trace file
+struct TraceRecord
+{
+	uint64_t cycle;
+	uint64_t addr;
+	TransactionType transType;
+};
+
+//one point of the sweep along with its results
+struct SweepJob
+{
+	string deviceIniFilename;
+	IniReader::OverrideMap overrides;
+	string visFilename;
+
+	uint64_t reads;
+	uint64_t writes;
+	uint64_t totalReadLatency; // in cycles
+	double bandwidth; // in GB/s
+	double tCK;
+	uint64_t cycles; // simulated
+	map<uint64_t, deque<uint64_t> > pendingReads; // address -> cycles the reads were added on
+
+	SweepJob() : reads(0), writes(0), totalReadLatency(0), bandwidth(0.0), tCK(0.0), cycles(0) {}
+
+	void readComplete(unsigned id, uint64_t addr, uint64_t cycle)
+	{
+		deque<uint64_t> &added = pendingReads[addr];
+		totalReadLatency += cycle - added.front();
+		added.pop_front();
+		reads++;
+	}
+	void writeComplete(unsigned id, uint64_t addr, uint64_t cycle)
+	{
+		writes++;
+	}
+};
+
+//everything the worker threads share
+struct Sweep
+{
+	vector<TraceRecord> trace;
+	vector<SweepJob> jobs;
+	string systemIniFilename;
+	string pwdString;
+	string traceFileName;
+	unsigned megsOfMemory;
+	uint64_t numCycles;
+	bool skipIdle;
+	bool runToCompletion;
+
+	pthread_mutex_t lock;
+	size_t nextJob;
+	size_t jobsDone;
+};
+
+void usage()
+{
+	cout << "DRAMSim2 Sweep Usage: " << endl;
+	cout << "DRAMSimSweep -t tracefile -s system.ini -d ini/device.ini [-d ini/device2.ini ...] [-c #] [-p pwd] [-S 2048] [-n] [-i] [-C] [-T #] [-r sweep.csv] [-o OPTION_A=1:2:3,tFAW=19:20]" <<endl;
+	cout << "\t-t, --tracefile=FILENAME \tspecify a tracefile to run  "<<endl;
+	cout << "\t-s, --systemini=FILENAME \tspecify an ini file that describes the memory system parameters  "<<endl;
+	cout << "\t-d, --deviceini=FILENAME \tspecify an ini file that describes the device-level parameters; give it more than once to sweep over devices"<<endl;
+	cout << "\t-c, --numcycles=# \t\tspecify number of cycles to run each simulation for [default=1000] "<<endl;
+	cout << "\t-o, --option=OPTION_A=1:2,tFAW=14:19\toverwrite ini file options; every combination of the colon separated values is simulated"<<endl;
+	cout << "\t-p, --pwd=DIRECTORY\t\tSet the working directory (i.e. usually DRAMSim directory where ini/ and results/ are)"<<endl;
+	cout << "\t-S, --size=# \t\t\tSize of the memory system in megabytes [default=2048M]"<<endl;
+	cout << "\t-n, --notiming \t\t\tDo not use the clock cycle information in the trace file"<<endl;
+	cout << "\t-v, --visfile \t\t\tVis output filename prefix; the job number is appended [default=sweep]"<<endl;
+	cout << "\t-i, --skipidle \t\t\tJump over cycles in which the memory system is idle (same results, less time)"<<endl;
+	cout << "\t-C, --complete \t\t\tRun each job until the whole trace has been simulated and the memory system is empty; -c becomes an upper limit"<<endl;
+	cout << "\t-T, --threads=# \t\tNumber of simulations to run at once [default=number of CPUs]"<<endl;
+	cout << "\t-r, --results=FILENAME \tWhere to write the table with the results of all configurations [default=sweep.csv]"<<endl;
+}
+
+void readTrace(const string &traceFileName, TraceType traceType, bool useClockCycle, vector<TraceRecord> &trace)
+{
+	if (traceType == binary)
+	{
+		BinaryTraceReader binaryTrace(traceFileName);
+		trace.reserve(binaryTrace.numRecords());
+		while (!binaryTrace.eof())
+		{
+			const BinaryTraceRecord &binaryRecord = binaryTrace.next();
+			TraceRecord record;
+			record.addr = binaryRecord.addr;
+			record.transType = (TransactionType)binaryRecord.transType;
+			record.cycle = useClockCycle ? binaryRecord.cycle : 0;
+			trace.push_back(record);
+		}
+		return;
+	}
+
+	istream *traceFile = openTraceFile(traceFileName);
+	string line;
+
+	if (!traceFile)
+	{
+		cout << "== Error - Could not open trace file"<<endl;
+		exit(0);
+	}
+
+	while (getline(*traceFile, line))
+	{
+		if (line.size() == 0)
+		{
+			continue;
+		}
+		TraceRecord record;
+		record.cycle = 0;
+		void *data = parseTraceFileLine(line, record.addr, record.transType, record.cycle, traceType, useClockCycle);
+		// only the timing is swept, so the write data isn't needed
+		free(data);
+		trace.push_back(record);
+	}
+	delete traceFile;
+}
+
+//the same loop as TraceBasedSim, just fed from memory
+void runJob(Sweep &sweep, SweepJob &job, MultiChannelMemorySystem *memorySystem)
+{
+	const Config &config = memorySystem->getConfig();
+	Transaction *trans = NULL;
+	bool pendingTrans = false;
+	size_t nextRecord = 0;
+	uint64_t clockCycle = 0;
+	uint64_t i;
+
+	for (i=0; i<sweep.numCycles; i++)
+	{
+		bool traceDone = nextRecord == sweep.trace.size();
+		if (sweep.runToCompletion && traceDone && !pendingTrans && memorySystem->isDrained())
+		{
+			break;
+		}
+
+		if (sweep.skipIdle && (pendingTrans ? i < clockCycle : traceDone))
+		{
+			uint64_t waitCycles = (pendingTrans ? clockCycle : sweep.numCycles) - i;
+			i += memorySystem->skipIdleCycles(waitCycles);
+			if (i >= sweep.numCycles)
+			{
+				break;
+			}
+		}
+
+		if (!pendingTrans)
+		{
+			if (nextRecord < sweep.trace.size())
+			{
+				const TraceRecord &record = sweep.trace[nextRecord++];
+				clockCycle = record.cycle;
+				trans = new Transaction(record.transType, record.addr, NULL);
+				alignTransactionAddress(*trans, config);
+				pendingTrans = true;
+			}
+		}
+		if (pendingTrans && i >= clockCycle)
+		{
+			uint64_t addr = trans->address;
+			bool isRead = trans->transactionType == DATA_READ;
+			pendingTrans = !memorySystem->addTransaction(trans);
+			if (!pendingTrans)
+			{
+				if (isRead)
+				{
+					job.pendingReads[addr].push_back(i);
+				}
+				trans = NULL;
+			}
+		}
+
+		memorySystem->update();
+	}
+
+	uint64_t bytesTransferred = (job.reads + job.writes) * config.TRANSACTION_SIZE;
+	job.tCK = config.tCK;
+	job.cycles = i;
+	job.bandwidth = ((double)bytesTransferred / (1024.0*1024.0*1024.0)) / ((double)job.cycles * config.tCK * 1E-9);
+	delete trans;
+}
+
+void *sweepWorker(void *arg)
+{
+	Sweep &sweep = *(Sweep *)arg;
+
+	while (true)
+	{
+		pthread_mutex_lock(&sweep.lock);
+		if (sweep.nextJob == sweep.jobs.size())
+		{
+			pthread_mutex_unlock(&sweep.lock);
+			break;
+		}
+		SweepJob &job = sweep.jobs[sweep.nextJob++];
+
+		// RegisterCallbacks() also sets the power callback, which is shared by all
+		// memory systems, so create them one at a time
+		MultiChannelMemorySystem *memorySystem = new MultiChannelMemorySystem(job.deviceIniFilename, sweep.systemIniFilename, sweep.pwdString, sweep.traceFileName, sweep.megsOfMemory, &job.visFilename, &job.overrides);
+		memorySystem->setCPUClockSpeed(0);
+		TransactionCompleteCB *readDone = new Callback<SweepJob, void, unsigned, uint64_t, uint64_t>(&job, &SweepJob::readComplete);
+		TransactionCompleteCB *writeDone = new Callback<SweepJob, void, unsigned, uint64_t, uint64_t>(&job, &SweepJob::writeComplete);
+		memorySystem->RegisterCallbacks(readDone, writeDone, NULL);
+		pthread_mutex_unlock(&sweep.lock);
+
+		runJob(sweep, job, memorySystem);
+		memorySystem->printStats(true);
+		delete memorySystem;
+		delete readDone;
+		delete writeDone;
+
+		pthread_mutex_lock(&sweep.lock);
+		sweep.jobsDone++;
+		cerr << "== finished "<<sweep.jobsDone<<"/"<<sweep.jobs.size()<<" ("<<job.visFilename<<")"<<endl;
+		pthread_mutex_unlock(&sweep.lock);
+	}
+	return NULL;
+}
+
+//one job for every device and every combination of the override values
+void buildJobs(const vector<string> &deviceIniFilenames, const IniReader::OverrideMap &sweepValues, const string &visPrefix, vector<SweepJob> &jobs)
+{
+	vector<string> keys;
+	vector< vector<string> > values;
+	for (IniReader::OverrideIterator it=sweepValues.begin(); it != sweepValues.end(); it++)
+	{
+		keys.push_back(it->first);
+		values.push_back(vector<string>());
+		size_t start = 0, colon;
+		do
+		{
+			colon = it->second.find(':', start);
+			values.back().push_back(it->second.substr(start, colon == string::npos ? string::npos : colon-start));
+			start = colon+1;
+		} while (colon != string::npos);
+	}
+
+	for (size_t d=0; d<deviceIniFilenames.size(); d++)
+	{
+		vector<size_t> choice(keys.size(), 0);
+		while (true)
+		{
+			SweepJob job;
+			job.deviceIniFilename = deviceIniFilenames[d];
+			for (size_t k=0; k<keys.size(); k++)
+			{
+				job.overrides[keys[k]] = values[k][choice[k]];
+			}
+			stringstream visFilename;
+			visFilename << visPrefix << "." << jobs.size();
+			job.visFilename = visFilename.str();
+			jobs.push_back(job);
+
+			// advance to the next combination, odometer style
+			size_t k = 0;
+			for (; k<keys.size(); k++)
+			{
+				if (++choice[k] < values[k].size())
+				{
+					break;
+				}
+				choice[k] = 0;
+			}
+			if (k == keys.size())
+			{
+				break;
+			}
+		}
+	}
+}
+
+void printResults(const Sweep &sweep, ostream &out)
+{
+	out.precision(3);
+	out.setf(ios::fixed,ios::floatfield);
+	out << "job,device,options,reads,writes,average_read_latency_ns,bandwidth_GB/s,cycles"<<endl;
+	for (size_t i=0; i<sweep.jobs.size(); i++)
+	{
+		const SweepJob &job = sweep.jobs[i];
+		out << i << "," << job.deviceIniFilename << ",\"";
+		for (IniReader::OverrideIterator it=job.overrides.begin(); it != job.overrides.end(); it++)
+		{
+			out << (it == job.overrides.begin() ? "" : ",") << it->first << "=" << it->second;
+		}
+		double averageLatency = job.reads ? (double)job.totalReadLatency / job.reads * job.tCK : 0.0;
+		out << "\"," << job.reads << "," << job.writes << "," << averageLatency << "," << job.bandwidth << "," << job.cycles << endl;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int c;
+	Sweep sweep;
+	vector<string> deviceIniFilenames;
+	string visPrefix("sweep");
+	string resultsFilename("sweep.csv");
+	bool useClockCycle=true;
+	unsigned numThreads = sysconf(_SC_NPROCESSORS_ONLN);
+	IniReader::OverrideMap *sweepValues = NULL;
+
+	sweep.systemIniFilename = "system.ini";
+	sweep.megsOfMemory = 2048;
+	sweep.numCycles = 1000;
+	sweep.skipIdle = false;
+	sweep.runToCompletion = false;
+	bool numCyclesGiven = false;
+
+	//getopt stuff
+	while (1)
+	{
+		static struct option long_options[] =
+		{
+			{"deviceini", required_argument, 0, 'd'},
+			{"tracefile", required_argument, 0, 't'},
+			{"systemini", required_argument, 0, 's'},
+			{"pwd", required_argument, 0, 'p'},
+			{"numcycles",  required_argument,	0, 'c'},
+			{"option",  required_argument,	0, 'o'},
+			{"help", no_argument, 0, 'h'},
+			{"size", required_argument, 0, 'S'},
+			{"visfile", required_argument, 0, 'v'},
+			{"notiming", no_argument, 0, 'n'},
+			{"skipidle", no_argument, 0, 'i'},
+			{"complete", no_argument, 0, 'C'},
+			{"threads", required_argument, 0, 'T'},
+			{"results", required_argument, 0, 'r'},
+			{0, 0, 0, 0}
+		};
+		int option_index=0; //for getopt
+		c = getopt_long (argc, argv, "t:s:c:d:o:p:S:v:niCT:r:h", long_options, &option_index);
+		if (c == -1)
+		{
+			break;
+		}
+		switch (c)
+		{
+		case 'h':
+		case '?':
+			usage();
+			exit(0);
+			break;
+		case 't':
+			sweep.traceFileName = string(optarg);
+			break;
+		case 's':
+			sweep.systemIniFilename = string(optarg);
+			break;
+		case 'd':
+			deviceIniFilenames.push_back(string(optarg));
+			break;
+		case 'c':
+			sweep.numCycles = strtoull(optarg, NULL, 10);
+			numCyclesGiven = true;
+			break;
+		case 'S':
+			sweep.megsOfMemory=atoi(optarg);
+			break;
+		case 'p':
+			sweep.pwdString = string(optarg);
+			break;
+		case 'n':
+			useClockCycle=false;
+			break;
+		case 'i':
+			sweep.skipIdle=true;
+			break;
+		case 'C':
+			sweep.runToCompletion=true;
+			break;
+		case 'T':
+			numThreads=atoi(optarg);
+			break;
+		case 'v':
+			visPrefix = string(optarg);
+			break;
+		case 'r':
+			resultsFilename = string(optarg);
+			break;
+		case 'o':
+			delete sweepValues;
+			sweepValues = IniReader::ParseOverrides(string(optarg));
+			break;
+		}
+	}
+
+	if (sweep.traceFileName.length() == 0 || deviceIniFilenames.size() == 0)
+	{
+		ERROR("Please provide a trace file and at least one device ini file");
+		usage();
+		exit(-1);
+	}
+	//without a -c, run for as long as the trace takes
+	if (sweep.runToCompletion && !numCyclesGiven)
+	{
+		sweep.numCycles = (uint64_t)-1;
+	}
+	if (numThreads == 0)
+	{
+		numThreads = 1;
+	}
+
+	//ignore the pwd argument if the argument is an absolute path
+	if (sweep.pwdString.length() > 0 && sweep.traceFileName[0] != '/')
+	{
+		sweep.traceFileName = sweep.pwdString + "/" + sweep.traceFileName;
+	}
+
+	DEBUG("== Loading trace file '"<<sweep.traceFileName<<"' == ");
+	readTrace(sweep.traceFileName, getTraceType(sweep.traceFileName), useClockCycle, sweep.trace);
+
+	buildJobs(deviceIniFilenames, sweepValues ? *sweepValues : IniReader::OverrideMap(), visPrefix, sweep.jobs);
+	delete sweepValues;
+	DEBUG("== Running "<<sweep.jobs.size()<<" configurations on "<<numThreads<<" threads ==");
+
+	pthread_mutex_init(&sweep.lock, NULL);
+	sweep.nextJob = 0;
+	sweep.jobsDone = 0;
+	vector<pthread_t> threads(numThreads);
+	for (size_t i=0; i<numThreads; i++)
+	{
+		if (pthread_create(&threads[i], NULL, sweepWorker, &sweep) != 0)
+		{
+			ERROR("Cannot create sweep thread");
+			abort();
+		}
+	}
+	for (size_t i=0; i<numThreads; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+	pthread_mutex_destroy(&sweep.lock);
+
+	ofstream results(resultsFilename.c_str());
+	if (!results)
+	{
+		ERROR("Cannot open '"<<resultsFilename<<"'");
+		exit(-1);
+	}
+	printResults(sweep, results);
+	cerr << "== results written to "<<resultsFilename<<endl;
+}
@@ -39,6 +39,7 @@
 #include <string>
 #include <cstdlib>
 #include <stdint.h>
+#include <algorithm>
 #include "PrintMacros.h"
 
 #ifdef __APPLE__
@@ -58,95 +59,12 @@
 extern std::ofstream cmd_verify_out; //used by BusPacket.cpp if VERIFICATION_OUTPUT is enabled
 //extern std::ofstream visDataOut;
 
-//TODO: namespace these to DRAMSim:: 
-extern bool VERIFICATION_OUTPUT; // output suitable to feed to modelsim
-
-extern bool DEBUG_TRANS_Q;
-extern bool DEBUG_CMD_Q;
-extern bool DEBUG_ADDR_MAP;
-extern bool DEBUG_BANKSTATE;
-extern bool DEBUG_BUS;
-extern bool DEBUG_BANKS;
-extern bool DEBUG_POWER;
-extern bool USE_LOW_POWER;
-extern bool VIS_FILE_OUTPUT;
-
-extern uint64_t TOTAL_STORAGE;
-extern unsigned NUM_BANKS;
-extern unsigned NUM_BANKS_LOG;
-extern unsigned NUM_RANKS;
-extern unsigned NUM_RANKS_LOG;
-extern unsigned NUM_CHANS;
-extern unsigned NUM_CHANS_LOG;
-extern unsigned NUM_ROWS;
-extern unsigned NUM_ROWS_LOG;
-extern unsigned NUM_COLS;
-extern unsigned NUM_COLS_LOG;
-extern unsigned DEVICE_WIDTH;
-extern unsigned BYTE_OFFSET_WIDTH;
-extern unsigned TRANSACTION_SIZE;
-extern unsigned THROW_AWAY_BITS;
-extern unsigned COL_LOW_BIT_WIDTH;
-
-//in nanoseconds
-extern unsigned REFRESH_PERIOD;
-extern float tCK;
-
-extern unsigned CL;
-extern unsigned AL;
-#define RL (CL+AL)
-#define WL (RL-1)
-extern unsigned BL;
-extern unsigned tRAS;
-extern unsigned tRCD;
-extern unsigned tRRD;
-extern unsigned tRC;
-extern unsigned tRP;
-extern unsigned tCCD;
-extern unsigned tRTP;
-extern unsigned tWTR;
-extern unsigned tWR;
-extern unsigned tRTRS;
-extern unsigned tRFC;
-extern unsigned tFAW;
-extern unsigned tCKE;
-extern unsigned tXP;
-
-extern unsigned tCMD;
-
-/* For power parameters (current and voltage), see externs in MemoryController.cpp */ 
-
-extern unsigned NUM_DEVICES;
-
-//same bank
-#define READ_TO_PRE_DELAY (AL+BL/2+ max(tRTP,tCCD)-tCCD)
-#define WRITE_TO_PRE_DELAY (WL+BL/2+tWR)
-#define READ_TO_WRITE_DELAY (RL+BL/2+tRTRS-WL)
-#define READ_AUTOPRE_DELAY (AL+tRTP+tRP)
-#define WRITE_AUTOPRE_DELAY (WL+BL/2+tWR+tRP)
-#define WRITE_TO_READ_DELAY_B (WL+BL/2+tWTR) //interbank
-#define WRITE_TO_READ_DELAY_R (WL+BL/2+tRTRS-RL) //interrank
-
-extern unsigned JEDEC_DATA_BUS_BITS;
-
-//Memory Controller related parameters
-extern unsigned TRANS_QUEUE_DEPTH;
-extern unsigned CMD_QUEUE_DEPTH;
-
-extern unsigned EPOCH_LENGTH;
-
-extern unsigned TOTAL_ROW_ACCESSES;
-
-extern std::string ROW_BUFFER_POLICY;
-extern std::string SCHEDULING_POLICY;
-extern std::string ADDRESS_MAPPING_SCHEME;
-extern std::string QUEUING_STRUCTURE;
-
 enum TraceType
 {
 	k6,
 	mase,
-	misc
+	misc,
+	binary
 };
 
 enum AddressMappingScheme
@@ -164,7 +82,9 @@ enum AddressMappingScheme
 enum RowBufferPolicy
 {
 	OpenPage,
-	ClosePage
+	ClosePage,
+	//open page, but each bank predicts whether to keep an idle row open
+	AdaptivePage
 };
 
 // Only used in CommandQueue
@@ -177,22 +97,141 @@ enum QueuingStructure
 enum SchedulingPolicy
 {
 	RankThenBankRoundRobin,
-	BankThenRankRoundRobin
+	BankThenRankRoundRobin,
+	FRFCFS // row hits first, then oldest first
 };
 
 
-// set by IniReader.cpp
-
-
 namespace DRAMSim
 {
 typedef void (*returnCallBack_t)(unsigned id, uint64_t addr, uint64_t clockcycle);
 typedef void (*powerCallBack_t)(double bgpower, double burstpower, double refreshpower, double actprepower);
 
-extern RowBufferPolicy rowBufferPolicy;
-extern SchedulingPolicy schedulingPolicy;
-extern AddressMappingScheme addressMappingScheme;
-extern QueuingStructure queuingStructure;
+// Every parameter of one memory system. Each MultiChannelMemorySystem owns
+// one (filled in by its IniReader) and hands a const reference down to the
+// objects it creates, so several differently configured memory systems can
+// live in the same process.
+struct Config
+{
+	bool VERIFICATION_OUTPUT; // output suitable to feed to modelsim
+
+	bool DEBUG_TRANS_Q;
+	bool DEBUG_CMD_Q;
+	bool DEBUG_ADDR_MAP;
+	bool DEBUG_BANKSTATE;
+	bool DEBUG_BUS;
+	bool DEBUG_BANKS;
+	bool DEBUG_POWER;
+	bool USE_LOW_POWER;
+	bool TRUST_CONTROLLER; // ranks skip their own copy of the timing checks
+	bool VIS_FILE_OUTPUT;
+
+	uint64_t TOTAL_STORAGE;
+	unsigned NUM_BANKS;
+	unsigned NUM_BANKS_LOG;
+	unsigned NUM_RANKS;
+	unsigned NUM_RANKS_LOG;
+	unsigned NUM_CHANS;
+	unsigned NUM_CHANS_LOG;
+	unsigned NUM_ROWS;
+	unsigned NUM_ROWS_LOG;
+	unsigned NUM_COLS;
+	unsigned NUM_COLS_LOG;
+	unsigned DEVICE_WIDTH;
+	unsigned BYTE_OFFSET_WIDTH;
+	unsigned TRANSACTION_SIZE;
+	unsigned THROW_AWAY_BITS;
+	unsigned COL_LOW_BIT_WIDTH;
+
+	//in nanoseconds
+	unsigned REFRESH_PERIOD;
+	float tCK;
+
+	unsigned CL;
+	unsigned AL;
+	unsigned BL;
+	unsigned tRAS;
+	unsigned tRCD;
+	unsigned tRRD;
+	unsigned tRC;
+	unsigned tRP;
+	unsigned tCCD;
+	unsigned tRTP;
+	unsigned tWTR;
+	unsigned tWR;
+	unsigned tRTRS;
+	unsigned tRFC;
+	unsigned tFAW;
+	unsigned tCKE;
+	unsigned tXP;
+
+	unsigned tCMD;
+
+	//power parameters; the power computations are localized to MemoryController.cpp
+	unsigned IDD0;
+	unsigned IDD1;
+	unsigned IDD2P;
+	unsigned IDD2Q;
+	unsigned IDD2N;
+	unsigned IDD3Pf;
+	unsigned IDD3Ps;
+	unsigned IDD3N;
+	unsigned IDD4W;
+	unsigned IDD4R;
+	unsigned IDD5;
+	unsigned IDD6;
+	unsigned IDD6L;
+	unsigned IDD7;
+	float Vdd;
+
+	unsigned NUM_DEVICES;
+
+	unsigned JEDEC_DATA_BUS_BITS;
+
+	//Memory Controller related parameters
+	unsigned TRANS_QUEUE_DEPTH;
+	unsigned CMD_QUEUE_DEPTH;
+	//once this many writes are queued, only writes are scheduled until no more
+	//	than WRITE_LOW_WATERMARK are left; reads go first otherwise (0 turns this off)
+	unsigned WRITE_HIGH_WATERMARK;
+	unsigned WRITE_LOW_WATERMARK;
+	//how many transactions the controller can turn into commands per cycle
+	unsigned TRANS_DECODE_WIDTH;
+	//bandwidth of the link returning read data to the CPU (0 = one read per cycle)
+	unsigned RETURN_BYTES_PER_CYCLE;
+
+	//cycles within an epoch
+	unsigned EPOCH_LENGTH;
+
+	//row accesses allowed before closing (open page)
+	unsigned TOTAL_ROW_ACCESSES;
+	//adaptive_page: cycles a row predicted to stay open may sit idle before it is closed (0 = no limit)
+	unsigned ROW_IDLE_TIMEOUT;
+
+	// strings and their associated enums
+	std::string ROW_BUFFER_POLICY;
+	std::string SCHEDULING_POLICY;
+	std::string ADDRESS_MAPPING_SCHEME;
+	std::string QUEUING_STRUCTURE;
+
+	RowBufferPolicy rowBufferPolicy;
+	SchedulingPolicy schedulingPolicy;
+	AddressMappingScheme addressMappingScheme;
+	QueuingStructure queuingStructure;
+
+	unsigned RL() const { return CL+AL; }
+	unsigned WL() const { return RL()-1; }
+
+	//same bank
+	unsigned READ_TO_PRE_DELAY() const { return AL+BL/2+std::max(tRTP,tCCD)-tCCD; }
+	unsigned WRITE_TO_PRE_DELAY() const { return WL()+BL/2+tWR; }
+	unsigned READ_TO_WRITE_DELAY() const { return RL()+BL/2+tRTRS-WL(); }
+	unsigned READ_AUTOPRE_DELAY() const { return AL+tRTP+tRP; }
+	unsigned WRITE_AUTOPRE_DELAY() const { return WL()+BL/2+tWR+tRP; }
+	unsigned WRITE_TO_READ_DELAY_B() const { return WL()+BL/2+tWTR; } //interbank
+	unsigned WRITE_TO_READ_DELAY_R() const { return WL()+BL/2+tRTRS-RL(); } //interrank
+};
+
 //
 //FUNCTIONS
 //
@@ -47,6 +47,7 @@
 #include "MultiChannelMemorySystem.h"
 #include "Transaction.h"
 #include "IniReader.h"
+#include "TraceReader.h"
 
 
 using namespace DRAMSim;
@@ -139,7 +140,7 @@ class TransactionReceiver
 void usage()
 {
 	cout << "DRAMSim2 Usage: " << endl;
-	cout << "DRAMSim -t tracefile -s system.ini -d ini/device.ini [-c #] [-p pwd] [-q] [-S 2048] [-n] [-o OPTION_A=1234,tRC=14,tFAW=19]" <<endl;
+	cout << "DRAMSim -t tracefile -s system.ini -d ini/device.ini [-c #] [-p pwd] [-q] [-S 2048] [-n] [-i] [-j #] [-P] [-C] [-o OPTION_A=1234,tRC=14,tFAW=19]" <<endl;
 	cout << "\t-t, --tracefile=FILENAME \tspecify a tracefile to run  "<<endl;
 	cout << "\t-s, --systemini=FILENAME \tspecify an ini file that describes the memory system parameters  "<<endl;
 	cout << "\t-d, --deviceini=FILENAME \tspecify an ini file that describes the device-level parameters"<<endl;
@@ -150,221 +151,10 @@ void usage()
 	cout << "\t-S, --size=# \t\t\tSize of the memory system in megabytes [default=2048M]"<<endl;
 	cout << "\t-n, --notiming \t\t\tDo not use the clock cycle information in the trace file"<<endl;
 	cout << "\t-v, --visfile \t\t\tVis output filename"<<endl;
-}
-#endif
-
-void *parseTraceFileLine(string &line, uint64_t &addr, enum TransactionType &transType, uint64_t &clockCycle, TraceType type, bool useClockCycle)
-{
-	size_t previousIndex=0;
-	size_t spaceIndex=0;
-	uint64_t *dataBuffer = NULL;
-	string addressStr="", cmdStr="", dataStr="", ccStr="";
-
-	switch (type)
-	{
-	case k6:
-	{
-		spaceIndex = line.find_first_of(" ", 0);
-
-		addressStr = line.substr(0, spaceIndex);
-		previousIndex = spaceIndex;
-
-		spaceIndex = line.find_first_not_of(" ", previousIndex);
-		cmdStr = line.substr(spaceIndex, line.find_first_of(" ", spaceIndex) - spaceIndex);
-		previousIndex = line.find_first_of(" ", spaceIndex);
-
-		spaceIndex = line.find_first_not_of(" ", previousIndex);
-		ccStr = line.substr(spaceIndex, line.find_first_of(" ", spaceIndex) - spaceIndex);
-
-		if (cmdStr.compare("P_MEM_WR")==0 ||
-		        cmdStr.compare("BOFF")==0)
-		{
-			transType = DATA_WRITE;
-		}
-		else if (cmdStr.compare("P_FETCH")==0 ||
-		         cmdStr.compare("P_MEM_RD")==0 ||
-		         cmdStr.compare("P_LOCK_RD")==0 ||
-		         cmdStr.compare("P_LOCK_WR")==0)
-		{
-			transType = DATA_READ;
-		}
-		else
-		{
-			ERROR("== Unknown Command : "<<cmdStr);
-			exit(0);
-		}
-
-		istringstream a(addressStr.substr(2));//gets rid of 0x
-		a>>hex>>addr;
-
-		//if this is set to false, clockCycle will remain at 0, and every line read from the trace
-		//  will be allowed to be issued
-		if (useClockCycle)
-		{
-			istringstream b(ccStr);
-			b>>clockCycle;
-		}
-		break;
-	}
-	case mase:
-	{
-		spaceIndex = line.find_first_of(" ", 0);
-
-		addressStr = line.substr(0, spaceIndex);
-		previousIndex = spaceIndex;
-
-		spaceIndex = line.find_first_not_of(" ", previousIndex);
-		cmdStr = line.substr(spaceIndex, line.find_first_of(" ", spaceIndex) - spaceIndex);
-		previousIndex = line.find_first_of(" ", spaceIndex);
-
-		spaceIndex = line.find_first_not_of(" ", previousIndex);
-		ccStr = line.substr(spaceIndex, line.find_first_of(" ", spaceIndex) - spaceIndex);
-
-		if (cmdStr.compare("IFETCH")==0||
-		        cmdStr.compare("READ")==0)
-		{
-			transType = DATA_READ;
-		}
-		else if (cmdStr.compare("WRITE")==0)
-		{
-			transType = DATA_WRITE;
-		}
-		else
-		{
-			ERROR("== Unknown command in tracefile : "<<cmdStr);
-		}
-
-		istringstream a(addressStr.substr(2));//gets rid of 0x
-		a>>hex>>addr;
-
-		//if this is set to false, clockCycle will remain at 0, and every line read from the trace
-		//  will be allowed to be issued
-		if (useClockCycle)
-		{
-			istringstream b(ccStr);
-			b>>clockCycle;
-		}
-
-		break;
-	}
-	case misc:
-		spaceIndex = line.find_first_of(" ", spaceIndex+1);
-		if (spaceIndex == string::npos)
-		{
-			ERROR("Malformed line: '"<< line <<"'");
-		}
-
-		addressStr = line.substr(previousIndex,spaceIndex);
-		previousIndex=spaceIndex;
-
-		spaceIndex = line.find_first_of(" ", spaceIndex+1);
-		if (spaceIndex == string::npos)
-		{
-			cmdStr = line.substr(previousIndex+1);
-		}
-		else
-		{
-			cmdStr = line.substr(previousIndex+1,spaceIndex-previousIndex-1);
-			dataStr = line.substr(spaceIndex+1);
-		}
-
-		//convert address string -> number
-		istringstream b(addressStr.substr(2)); //substr(2) chops off 0x characters
-		b >>hex>> addr;
-
-		// parse command
-		if (cmdStr.compare("read") == 0)
-		{
-			transType=DATA_READ;
-		}
-		else if (cmdStr.compare("write") == 0)
-		{
-			transType=DATA_WRITE;
-		}
-		else
-		{
-			ERROR("INVALID COMMAND '"<<cmdStr<<"'");
-			exit(-1);
-		}
-		if (SHOW_SIM_OUTPUT)
-		{
-			DEBUGN("ADDR='"<<hex<<addr<<dec<<"',CMD='"<<transType<<"'");//',DATA='"<<dataBuffer[0]<<"'");
-		}
-
-		//parse data
-		//if we are running in a no storage mode, don't allocate space, just return NULL
-#ifndef NO_STORAGE
-		if (dataStr.size() > 0 && transType == DATA_WRITE)
-		{
-			// 32 bytes of data per transaction
-			dataBuffer = (uint64_t *)calloc(sizeof(uint64_t),4);
-			size_t strlen = dataStr.size();
-			for (int i=0; i < 4; i++)
-			{
-				size_t startIndex = i*16;
-				if (startIndex > strlen)
-				{
-					break;
-				}
-				size_t charsLeft = min(((size_t)16), strlen - startIndex + 1);
-				string piece = dataStr.substr(i*16,charsLeft);
-				istringstream iss(piece);
-				iss >> hex >> dataBuffer[i];
-			}
-			PRINTN("\tDATA=");
-			BusPacket::printData(dataBuffer);
-		}
-
-		PRINT("");
-#endif
-		break;
-	}
-	return dataBuffer;
-}
-
-#ifndef _SIM_
-
-void alignTransactionAddress(Transaction &trans)
-{
-	// zero out the low order bits which correspond to the size of a transaction
-
-	unsigned throwAwayBits = THROW_AWAY_BITS;
-
-	trans.address >>= throwAwayBits;
-	trans.address <<= throwAwayBits;
-}
-
-/** 
- * Override options can be specified on the command line as -o key1=value1,key2=value2
- * this method should parse the key-value pairs and put them into a map 
- **/ 
-IniReader::OverrideMap *parseParamOverrides(const string &kv_str)
-{
-	IniReader::OverrideMap *kv_map = new IniReader::OverrideMap(); 
-	size_t start = 0, comma=0, equal_sign=0;
-	// split the commas if they are there
-	while (1)
-	{
-		equal_sign = kv_str.find('=', start); 
-		if (equal_sign == string::npos)
-		{
-			break;
-		}
-
-		comma = kv_str.find(',', equal_sign);
-		if (comma == string::npos)
-		{
-			comma = kv_str.length();
-		}
-
-		string key = kv_str.substr(start, equal_sign-start);
-		string value = kv_str.substr(equal_sign+1, comma-equal_sign-1); 
-
-		(*kv_map)[key] = value; 
-		start = comma+1;
-
-	}
-	return kv_map; 
+	cout << "\t-i, --skipidle \t\t\tJump over cycles in which the memory system is idle (same results, less time)"<<endl;
+	cout << "\t-j, --parallel=# \t\tSimulate each channel on its own thread, syncing every # cycles (same results)"<<endl;
+	cout << "\t-C, --complete \t\t\tRun until the whole trace has been simulated and the memory system is empty; -c becomes an upper limit"<<endl;
+	cout << "\t-P, --pipeline \t\t\tRead and parse the trace on its own thread while simulating (same results)"<<endl;
 }
 
 int main(int argc, char **argv)
@@ -378,10 +168,15 @@ int main(int argc, char **argv)
 	string *visFilename = NULL;
 	unsigned megsOfMemory=2048;
 	bool useClockCycle=true;
+	bool skipIdle=false;
+	unsigned parallelSyncQuantum=0;
+	bool pipelineTrace=false;
+	bool runToCompletion=false;
 	
 	IniReader::OverrideMap *paramOverrides = NULL; 
 
-	unsigned numCycles=1000;
+	uint64_t numCycles=1000;
+	bool numCyclesGiven=false;
 	//getopt stuff
 	while (1)
 	{
@@ -398,10 +193,14 @@ int main(int argc, char **argv)
 			{"help", no_argument, 0, 'h'},
 			{"size", required_argument, 0, 'S'},
 			{"visfile", required_argument, 0, 'v'},
+			{"skipidle", no_argument, 0, 'i'},
+			{"parallel", required_argument, 0, 'j'},
+			{"pipeline", no_argument, 0, 'P'},
+			{"complete", no_argument, 0, 'C'},
 			{0, 0, 0, 0}
 		};
 		int option_index=0; //for getopt
-		c = getopt_long (argc, argv, "t:s:c:d:o:p:S:v:qn", long_options, &option_index);
+		c = getopt_long (argc, argv, "t:s:c:d:o:p:S:v:qnij:PC", long_options, &option_index);
 		if (c == -1)
 		{
 			break;
@@ -435,7 +234,8 @@ int main(int argc, char **argv)
 			deviceIniFilename = string(optarg);
 			break;
 		case 'c':
-			numCycles = atoi(optarg);
+			numCycles = strtoull(optarg, NULL, 10);
+			numCyclesGiven = true;
 			break;
 		case 'S':
 			megsOfMemory=atoi(optarg);
@@ -449,8 +249,20 @@ int main(int argc, char **argv)
 		case 'n':
 			useClockCycle=false;
 			break;
+		case 'i':
+			skipIdle=true;
+			break;
+		case 'j':
+			parallelSyncQuantum=atoi(optarg);
+			break;
+		case 'P':
+			pipelineTrace=true;
+			break;
+		case 'C':
+			runToCompletion=true;
+			break;
 		case 'o':
-			paramOverrides = parseParamOverrides(string(optarg)); 
+			paramOverrides = IniReader::ParseOverrides(string(optarg)); 
 			break;
 		case 'v':
 			visFilename = new string(optarg);
@@ -462,29 +274,11 @@ int main(int argc, char **argv)
 		}
 	}
 
-	// get the trace filename
-	string temp = traceFileName.substr(traceFileName.find_last_of("/")+1);
-
-	//get the prefix of the trace name
-	temp = temp.substr(0,temp.find_first_of("_"));
-	if (temp=="mase")
-	{
-		traceType = mase;
-	}
-	else if (temp=="k6")
-	{
-		traceType = k6;
-	}
-	else if (temp=="misc")
+	//without a -c, run for as long as the trace takes
+	if (runToCompletion && !numCyclesGiven)
 	{
-		traceType = misc;
+		numCycles = (uint64_t)-1;
 	}
-	else
-	{
-		ERROR("== Unknown Tracefile Type : "<<temp);
-		exit(0);
-	}
-
 
 	// no default value for the default model name
 	if (deviceIniFilename.length() == 0)
@@ -501,15 +295,18 @@ int main(int argc, char **argv)
 		traceFileName = pwdString + "/" +traceFileName;
 	}
 
+	traceType = getTraceType(traceFileName);
+
 	DEBUG("== Loading trace file '"<<traceFileName<<"' == ");
 
-	ifstream traceFile;
+	istream *traceFile = NULL;
 	string line;
 
 
 	MultiChannelMemorySystem *memorySystem = new MultiChannelMemorySystem(deviceIniFilename, systemIniFilename, pwdString, traceFileName, megsOfMemory, visFilename, paramOverrides);
 	// set the frequency ratio to 1:1
 	memorySystem->setCPUClockSpeed(0); 
+	memorySystem->enableParallelChannels(parallelSyncQuantum);
 
 	// don't need this anymore 
 	delete paramOverrides;
@@ -533,58 +330,125 @@ int main(int argc, char **argv)
 	Transaction *trans=NULL;
 	bool pendingTrans = false;
 
-	traceFile.open(traceFileName.c_str());
+	BinaryTraceReader *binaryTrace = NULL;
+	if (traceType == binary)
+	{
+		binaryTrace = new BinaryTraceReader(traceFileName);
+	}
+	else
+	{
+		traceFile = openTraceFile(traceFileName);
 
-	if (!traceFile.is_open())
+		if (!traceFile)
+		{
+			cout << "== Error - Could not open trace file"<<endl;
+			exit(0);
+		}
+	}
+	TraceIngestThread *ingest = NULL;
+	if (pipelineTrace)
 	{
-		cout << "== Error - Could not open trace file"<<endl;
-		exit(0);
+		ingest = new TraceIngestThread(traceFile, binaryTrace, traceType, useClockCycle);
 	}
 
 	for (size_t i=0;i<numCycles;i++)
 	{
-		if (!pendingTrans)
+		bool traceDone = ingest ? ingest->eof() : binaryTrace ? binaryTrace->eof() : traceFile->eof();
+
+		if (runToCompletion && traceDone && !pendingTrans)
 		{
-			if (!traceFile.eof())
+			//nothing else is coming, so parallel channels can each drain on
+			//	their own instead of syncing every cycle to check
+			if (parallelSyncQuantum > 0)
+			{
+				i += memorySystem->runUntilDrained(numCycles - i);
+			}
+			if (i < numCycles && memorySystem->isDrained())
+			{
+				DEBUG("== Trace completed after "<<i<<" cycles");
+				break;
+			}
+			if (i >= numCycles)
 			{
-				getline(traceFile, line);
+				break;
+			}
+		}
+
+		//if we're just waiting for the trace to catch up (or it's empty), the
+		//memory system can jump over however many of those cycles it is idle for
+		if (skipIdle && (pendingTrans ? i < clockCycle : traceDone))
+		{
+			uint64_t waitCycles = (pendingTrans ? clockCycle : numCycles) - i;
+			i += memorySystem->skipIdleCycles(waitCycles);
+			if (i >= numCycles)
+			{
+				break;
+			}
+		}
+
+		if (!pendingTrans && !traceDone)
+		{
+			if (ingest)
+			{
+				TraceIngestThread::Entry entry = ingest->next();
+				trans = entry.trans;
+				if (trans)
+				{
+					clockCycle = entry.clockCycle;
+				}
+				else
+				{
+					DEBUG("WARNING: Skipping line "<<lineNumber<< " ('') in tracefile");
+				}
+			}
+			else if (binaryTrace)
+			{
+				const BinaryTraceRecord &record = binaryTrace->next();
+				if (useClockCycle)
+				{
+					clockCycle = record.cycle;
+				}
+				trans = new Transaction((TransactionType)record.transType, record.addr, binaryTrace->getData(record));
+			}
+			else
+			{
+				getline(*traceFile, line);
 
 				if (line.size() > 0)
 				{
 					data = parseTraceFileLine(line, addr, transType,clockCycle, traceType,useClockCycle);
 					trans = new Transaction(transType, addr, data);
-					alignTransactionAddress(*trans); 
+				}
+				else
+				{
+					DEBUG("WARNING: Skipping line "<<lineNumber<< " ('" << line << "') in tracefile");
+				}
+			}
+			lineNumber++;
 
-					if (i>=clockCycle)
+			if (trans)
+			{
+				alignTransactionAddress(*trans, memorySystem->getConfig()); 
+
+				if (i>=clockCycle)
+				{
+					if (!(*memorySystem).addTransaction(trans))
 					{
-						if (!(*memorySystem).addTransaction(trans))
-						{
-							pendingTrans = true;
-						}
-						else
-						{
-#ifdef RETURN_TRANSACTIONS
-							transactionReceiver.add_pending(trans, i); 
-#endif
-							// the memory system accepted our request so now it takes ownership of it
-							trans = NULL; 
-						}
+						pendingTrans = true;
 					}
 					else
 					{
-						pendingTrans = true;
+#ifdef RETURN_TRANSACTIONS
+						transactionReceiver.add_pending(trans, i); 
+#endif
+						// the memory system accepted our request so now it takes ownership of it
+						trans = NULL; 
 					}
 				}
 				else
 				{
-					DEBUG("WARNING: Skipping line "<<lineNumber<< " ('" << line << "') in tracefile");
+					pendingTrans = true;
 				}
-				lineNumber++;
-			}
-			else
-			{
-				//we're out of trace, set pending=false and let the thing spin without adding transactions
-				pendingTrans = false; 
 			}
 		}
 
@@ -603,7 +467,9 @@ int main(int argc, char **argv)
 		(*memorySystem).update();
 	}
 
-	traceFile.close();
+	delete ingest;
+	delete traceFile;
+	delete binaryTrace;
 	memorySystem->printStats(true);
 	// make valgrind happy
 	if (trans)
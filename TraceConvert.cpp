@@ -0,0 +1,108 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+//TraceConvert.cpp
+//
+//Converts a k6, mase or misc text trace into the binary trace format read by
+//BinaryTraceReader
+//
+
+#include <iostream>
+
+#include "TraceReader.h"
+
+using namespace DRAMSim;
+using namespace std;
+
+int SHOW_SIM_OUTPUT = 0;
+
+void usage()
+{
+	cout << "DRAMSim2 Trace Converter Usage: " << endl;
+	cout << "DRAMSimTraceConvert input.trc output.bin" << endl;
+	cout << "\tThe format of input.trc is given by its name prefix (k6_, mase_, misc_) like for DRAMSim -t" << endl;
+	cout << "\tThe clock cycles are always kept; DRAMSim -n still ignores them when running the binary trace" << endl;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 3)
+	{
+		usage();
+		exit(-1);
+	}
+	string textFileName(argv[1]);
+	string binaryFileName(argv[2]);
+
+	TraceType traceType = getTraceType(textFileName);
+	if (traceType == binary)
+	{
+		ERROR("'"<<textFileName<<"' is already a binary trace");
+		exit(-1);
+	}
+
+	istream *traceFile = openTraceFile(textFileName);
+	if (!traceFile)
+	{
+		cout << "== Error - Could not open trace file"<<endl;
+		exit(0);
+	}
+
+	//the text parser only hands back write data when storage is compiled in
+	bool withData = false;
+#ifndef NO_STORAGE
+	withData = traceType == misc;
+#endif
+	BinaryTraceWriter writer(binaryFileName, withData);
+
+	string line;
+	uint64_t numRecords = 0;
+	while (getline(*traceFile, line))
+	{
+		if (line.size() == 0)
+		{
+			continue;
+		}
+		uint64_t addr;
+		uint64_t clockCycle = 0;
+		enum TransactionType transType;
+		uint64_t *data = (uint64_t *)parseTraceFileLine(line, addr, transType, clockCycle, traceType, true);
+		writer.write(addr, transType, clockCycle, data);
+		free(data);
+		numRecords++;
+	}
+	delete traceFile;
+	writer.close();
+
+	cout << "== Wrote "<<numRecords<<" records to '"<<binaryFileName<<"'"<<endl;
+	return 0;
+}
@@ -0,0 +1,129 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+//TraceParseBench.cpp
+//
+//Measures how many lines per second parseTraceFileLine() gets through. The
+//trace is read into memory first so that only the parsing is timed.
+//
+
+#include <iostream>
+#include <sys/time.h>
+
+#include "TraceReader.h"
+
+using namespace DRAMSim;
+using namespace std;
+
+int SHOW_SIM_OUTPUT = 0;
+
+void usage()
+{
+	cout << "DRAMSim2 Trace Parser Benchmark Usage: " << endl;
+	cout << "DRAMSimTraceBench tracefile [passes]" << endl;
+	cout << "\tParses the (k6_, mase_ or misc_, optionally compressed) text trace passes times [default=10]" << endl;
+}
+
+static double now()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2 || argc > 3)
+	{
+		usage();
+		exit(-1);
+	}
+	string traceFileName(argv[1]);
+	unsigned passes = argc == 3 ? atoi(argv[2]) : 10;
+
+	TraceType traceType = getTraceType(traceFileName);
+	if (traceType == binary)
+	{
+		ERROR("'"<<traceFileName<<"' is a binary trace; there is nothing to parse");
+		exit(-1);
+	}
+	istream *traceFile = openTraceFile(traceFileName);
+	if (!traceFile)
+	{
+		cout << "== Error - Could not open trace file"<<endl;
+		exit(0);
+	}
+
+	//all lines back to back, so the timed loop doesn't touch the allocator
+	string text;
+	vector<size_t> lineStart;
+	string line;
+	while (getline(*traceFile, line))
+	{
+		if (line.size() > 0)
+		{
+			lineStart.push_back(text.size());
+			text += line;
+		}
+	}
+	lineStart.push_back(text.size());
+	delete traceFile;
+
+	size_t numLines = lineStart.size() - 1;
+	if (numLines == 0)
+	{
+		ERROR("'"<<traceFileName<<"' has no lines to parse");
+		exit(-1);
+	}
+
+	//something that depends on every parsed field so none of the work is optimized away
+	uint64_t checksum = 0;
+	double start = now();
+	for (unsigned pass=0; pass<passes; pass++)
+	{
+		for (size_t i=0; i<numLines; i++)
+		{
+			uint64_t addr = 0;
+			uint64_t clockCycle = 0;
+			enum TransactionType transType = DATA_READ;
+			void *data = parseTraceFileLine(text.data() + lineStart[i], lineStart[i+1] - lineStart[i], addr, transType, clockCycle, traceType, true, false);
+			free(data);
+			checksum += addr ^ clockCycle ^ transType;
+		}
+	}
+	double seconds = now() - start;
+
+	double totalLines = (double)numLines * passes;
+	cout << "== Parsed "<<numLines<<" lines "<<passes<<" times in "<<seconds<<"s (checksum "<<hex<<checksum<<dec<<")"<<endl;
+	cout << "== "<<(uint64_t)(totalLines / seconds)<<" lines/s, "<<(text.size() * (double)passes / seconds / (1<<20))<<" MB/s"<<endl;
+	return 0;
+}
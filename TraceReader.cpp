@@ -0,0 +1,857 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//TraceReader.cpp
+//
+//Parsing of the text and binary trace files used by the trace based front ends
+//
+
+#include <fstream>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "TraceReader.h"
+
+using namespace std;
+
+namespace DRAMSim
+{
+
+//binary traces are recognized by their header, otherwise the trace format
+//is given by the prefix of the trace's file name (mase_*, k6_*, misc_*)
+TraceType getTraceType(const string &traceFileName)
+{
+	if (BinaryTraceReader::isBinaryTrace(traceFileName))
+	{
+		return binary;
+	}
+
+	// get the trace filename
+	string temp = traceFileName.substr(traceFileName.find_last_of("/")+1);
+
+	//get the prefix of the trace name
+	temp = temp.substr(0,temp.find_first_of("_"));
+	if (temp=="mase")
+	{
+		return mase;
+	}
+	else if (temp=="k6")
+	{
+		return k6;
+	}
+	else if (temp=="misc")
+	{
+		return misc;
+	}
+	else
+	{
+		ERROR("== Unknown Tracefile Type : "<<temp);
+		exit(0);
+	}
+}
+
+//command names of each text trace format and the transactions they become
+struct TraceCommand
+{
+	TraceType traceType;
+	const char *name;
+	size_t length;
+	TransactionType transType;
+};
+
+#define TRACE_COMMAND(traceType, name, transType) {traceType, name, sizeof(name)-1, transType}
+static const TraceCommand traceCommands[] =
+{
+	TRACE_COMMAND(k6, "P_MEM_WR", DATA_WRITE),
+	TRACE_COMMAND(k6, "BOFF", DATA_WRITE),
+	TRACE_COMMAND(k6, "P_FETCH", DATA_READ),
+	TRACE_COMMAND(k6, "P_MEM_RD", DATA_READ),
+	TRACE_COMMAND(k6, "P_LOCK_RD", DATA_READ),
+	TRACE_COMMAND(k6, "P_LOCK_WR", DATA_READ),
+	TRACE_COMMAND(mase, "IFETCH", DATA_READ),
+	TRACE_COMMAND(mase, "READ", DATA_READ),
+	TRACE_COMMAND(mase, "WRITE", DATA_WRITE),
+	TRACE_COMMAND(misc, "read", DATA_READ),
+	TRACE_COMMAND(misc, "write", DATA_WRITE)
+};
+#undef TRACE_COMMAND
+
+static bool matchCommand(TraceType type, const char *cmd, const char *cmdEnd, TransactionType &transType)
+{
+	size_t length = cmdEnd - cmd;
+	for (size_t i=0; i<sizeof(traceCommands)/sizeof(traceCommands[0]); i++)
+	{
+		const TraceCommand &command = traceCommands[i];
+		if (command.traceType == type && command.length == length && memcmp(command.name, cmd, length) == 0)
+		{
+			transType = command.transType;
+			return true;
+		}
+	}
+	return false;
+}
+
+//these read a number the same way istringstream's >> (with hex or dec) does
+//for the fields found in traces: leading blanks are skipped, conversion stops
+//at the first character that isn't a digit, no digits gives 0 and values
+//that don't fit are clamped
+static uint64_t parseHex(const char *p, const char *end)
+{
+	const uint64_t max = (uint64_t)-1;
+	uint64_t value = 0;
+	while (p < end && (*p == ' ' || *p == '\t'))
+	{
+		p++;
+	}
+	for (; p < end; p++)
+	{
+		unsigned digit;
+		if (*p >= '0' && *p <= '9')
+		{
+			digit = *p - '0';
+		}
+		else if (*p >= 'a' && *p <= 'f')
+		{
+			digit = *p - 'a' + 10;
+		}
+		else if (*p >= 'A' && *p <= 'F')
+		{
+			digit = *p - 'A' + 10;
+		}
+		else
+		{
+			break;
+		}
+		if (value > (max >> 4))
+		{
+			return max;
+		}
+		value = (value << 4) | digit;
+	}
+	return value;
+}
+
+static uint64_t parseDecimal(const char *p, const char *end)
+{
+	const uint64_t max = (uint64_t)-1;
+	uint64_t value = 0;
+	while (p < end && (*p == ' ' || *p == '\t'))
+	{
+		p++;
+	}
+	for (; p < end && *p >= '0' && *p <= '9'; p++)
+	{
+		unsigned digit = *p - '0';
+		if (value > (max - digit) / 10)
+		{
+			return max;
+		}
+		value = value * 10 + digit;
+	}
+	return value;
+}
+
+//end of the ' ' separated field starting at p
+static const char *fieldEnd(const char *p, const char *end)
+{
+	const char *space = (const char *)memchr(p, ' ', end - p);
+	return space ? space : end;
+}
+
+static const char *skipSpaces(const char *p, const char *end)
+{
+	while (p < end && *p == ' ')
+	{
+		p++;
+	}
+	return p;
+}
+
+static void malformedLine(const char *line, size_t length)
+{
+	ERROR("Malformed line: '"<< string(line, length) <<"'");
+	exit(-1);
+}
+
+void *parseTraceFileLine(string &line, uint64_t &addr, enum TransactionType &transType, uint64_t &clockCycle, TraceType type, bool useClockCycle)
+{
+	return parseTraceFileLine(line.data(), line.size(), addr, transType, clockCycle, type, useClockCycle, true);
+}
+
+//works in place on the line; nothing is allocated unless there is write data to return
+void *parseTraceFileLine(const char *line, size_t length, uint64_t &addr, enum TransactionType &transType, uint64_t &clockCycle, TraceType type, bool useClockCycle, bool verbose)
+{
+	const char *lineEnd = line + length;
+	uint64_t *dataBuffer = NULL;
+
+	switch (type)
+	{
+	case k6:
+	case mase:
+	{
+		// <address> <command> <clock cycle>, separated by any number of spaces
+		const char *address = line;
+		const char *addressEnd = fieldEnd(address, lineEnd);
+		const char *cmd = skipSpaces(addressEnd, lineEnd);
+		const char *cmdEnd = fieldEnd(cmd, lineEnd);
+		const char *cc = skipSpaces(cmdEnd, lineEnd);
+		const char *ccEnd = fieldEnd(cc, lineEnd);
+		if (addressEnd - address < 2 || cmd == lineEnd || cc == lineEnd)
+		{
+			malformedLine(line, length);
+		}
+
+		if (!matchCommand(type, cmd, cmdEnd, transType))
+		{
+			if (type == k6)
+			{
+				ERROR("== Unknown Command : "<<string(cmd, cmdEnd - cmd));
+				exit(0);
+			}
+			ERROR("== Unknown command in tracefile : "<<string(cmd, cmdEnd - cmd));
+		}
+
+		addr = parseHex(address + 2, addressEnd); //+2 gets rid of 0x
+
+		//if this is set to false, clockCycle will remain at 0, and every line read from the trace
+		//  will be allowed to be issued
+		if (useClockCycle)
+		{
+			clockCycle = parseDecimal(cc, ccEnd);
+		}
+		break;
+	}
+	case binary:
+		ERROR("Binary traces are read with a BinaryTraceReader, not line by line");
+		exit(-1);
+	case misc:
+	{
+		// <address> <command> [data], separated by single spaces
+		const char *addressEnd = length > 1 ? fieldEnd(line + 1, lineEnd) : lineEnd;
+		if (addressEnd == lineEnd || addressEnd - line < 2)
+		{
+			malformedLine(line, length);
+		}
+		const char *cmd = addressEnd + 1;
+		const char *cmdEnd = fieldEnd(cmd, lineEnd);
+
+		addr = parseHex(line + 2, addressEnd); //+2 chops off 0x characters
+
+		if (!matchCommand(type, cmd, cmdEnd, transType))
+		{
+			ERROR("INVALID COMMAND '"<<string(cmd, cmdEnd - cmd)<<"'");
+			exit(-1);
+		}
+		if (verbose && SHOW_SIM_OUTPUT)
+		{
+			DEBUGN("ADDR='"<<hex<<addr<<dec<<"',CMD='"<<transType<<"'");//',DATA='"<<dataBuffer[0]<<"'");
+		}
+
+		//parse data
+		//if we are running in a no storage mode, don't allocate space, just return NULL
+#ifndef NO_STORAGE
+		const char *data = cmdEnd < lineEnd ? cmdEnd + 1 : lineEnd;
+		size_t dataLength = lineEnd - data;
+		if (dataLength > 0 && transType == DATA_WRITE)
+		{
+			// 32 bytes of data per transaction, 16 hex characters per word
+			dataBuffer = (uint64_t *)calloc(sizeof(uint64_t),4);
+			for (size_t i=0; i < 4 && i*16 <= dataLength; i++)
+			{
+				dataBuffer[i] = parseHex(data + i*16, data + min(i*16 + 16, dataLength));
+			}
+			if (verbose)
+			{
+				PRINTN("\tDATA=");
+				BusPacket::printData(dataBuffer);
+			}
+		}
+
+		if (verbose)
+		{
+			PRINT("");
+		}
+#endif
+		break;
+	}
+	}
+	return dataBuffer;
+}
+
+void alignTransactionAddress(Transaction &trans, const Config &config)
+{
+	// zero out the low order bits which correspond to the size of a transaction
+
+	unsigned throwAwayBits = config.THROW_AWAY_BITS;
+
+	trans.address >>= throwAwayBits;
+	trans.address <<= throwAwayBits;
+}
+
+BinaryTraceReader::BinaryTraceReader(const string &traceFileName) :
+	fileName(traceFileName),
+	fd(-1),
+	mapping(NULL),
+	mappingSize(0),
+	header(NULL),
+	cursor(NULL),
+	end(NULL),
+	recordSize(sizeof(BinaryTraceRecord))
+{
+	fd = open(traceFileName.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		ERROR("== Error - Could not open trace file '"<<traceFileName<<"'");
+		exit(-1);
+	}
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || (size_t)fileStat.st_size < sizeof(BinaryTraceHeader))
+	{
+		ERROR("'"<<traceFileName<<"' is too short to be a binary trace");
+		exit(-1);
+	}
+	mappingSize = fileStat.st_size;
+
+	void *addr = mmap(NULL, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (addr == MAP_FAILED)
+	{
+		ERROR("Cannot mmap '"<<traceFileName<<"': "<<strerror(errno));
+		exit(-1);
+	}
+	mapping = (char *)addr;
+	//records are only ever walked front to back
+	madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+
+	header = (const BinaryTraceHeader *)mapping;
+	if (memcmp(header->magic, BINARY_TRACE_MAGIC, sizeof(header->magic)) != 0 ||
+	        header->version != BINARY_TRACE_VERSION)
+	{
+		ERROR("'"<<traceFileName<<"' is not a version "<<BINARY_TRACE_VERSION<<" binary trace");
+		exit(-1);
+	}
+	if (header->flags & BINARY_TRACE_HAS_DATA)
+	{
+		recordSize += BINARY_TRACE_DATA_WORDS * sizeof(uint64_t);
+	}
+	size_t recordBytes = mappingSize - sizeof(BinaryTraceHeader);
+	if (recordBytes % recordSize != 0)
+	{
+		ERROR("'"<<traceFileName<<"' doesn't hold a whole number of "<<recordSize<<" byte records");
+		exit(-1);
+	}
+	if (header->numRecords != recordBytes / recordSize)
+	{
+		ERROR("'"<<traceFileName<<"' holds "<<recordBytes / recordSize<<" records but its header says "<<header->numRecords);
+		exit(-1);
+	}
+
+	cursor = mapping + sizeof(BinaryTraceHeader);
+	end = cursor + header->numRecords * recordSize;
+}
+
+BinaryTraceReader::~BinaryTraceReader()
+{
+	munmap(mapping, mappingSize);
+	::close(fd);
+}
+
+const BinaryTraceRecord &BinaryTraceReader::next()
+{
+	const BinaryTraceRecord *record = (const BinaryTraceRecord *)cursor;
+	//only reads and writes are ever written to a trace
+	if (record->transType != DATA_READ && record->transType != DATA_WRITE)
+	{
+		ERROR("== Unknown transaction type "<<record->transType<<" in record "<<
+		      (cursor - mapping - sizeof(BinaryTraceHeader)) / recordSize<<" of binary trace '"<<fileName<<"'");
+		exit(-1);
+	}
+	cursor += recordSize;
+	return *record;
+}
+
+void *BinaryTraceReader::getData(const BinaryTraceRecord &record) const
+{
+	//same as the text traces: no storage means no data
+#ifndef NO_STORAGE
+	if (record.hasData && (header->flags & BINARY_TRACE_HAS_DATA))
+	{
+		uint64_t *dataBuffer = (uint64_t *)calloc(sizeof(uint64_t), BINARY_TRACE_DATA_WORDS);
+		memcpy(dataBuffer, &record + 1, BINARY_TRACE_DATA_WORDS * sizeof(uint64_t));
+		return dataBuffer;
+	}
+#endif
+	return NULL;
+}
+
+bool BinaryTraceReader::isBinaryTrace(const string &traceFileName)
+{
+	char magic[sizeof(((BinaryTraceHeader *)NULL)->magic)];
+	FILE *file = fopen(traceFileName.c_str(), "rb");
+	if (!file)
+	{
+		return false;
+	}
+	bool isBinary = fread(magic, sizeof(magic), 1, file) == 1 &&
+	                memcmp(magic, BINARY_TRACE_MAGIC, sizeof(magic)) == 0;
+	fclose(file);
+	return isBinary;
+}
+
+BinaryTraceWriter::BinaryTraceWriter(const string &traceFileName, bool withData) :
+	file(NULL),
+	fileName(traceFileName)
+{
+	file = fopen(traceFileName.c_str(), "wb");
+	if (!file)
+	{
+		ERROR("Cannot open '"<<traceFileName<<"' for writing");
+		exit(-1);
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, BINARY_TRACE_MAGIC, sizeof(header.magic));
+	header.version = BINARY_TRACE_VERSION;
+	header.flags = withData ? BINARY_TRACE_HAS_DATA : 0;
+
+	//the record count gets filled in by close()
+	if (fwrite(&header, sizeof(header), 1, file) != 1)
+	{
+		ERROR("Cannot write to '"<<fileName<<"'");
+		exit(-1);
+	}
+}
+
+BinaryTraceWriter::~BinaryTraceWriter()
+{
+	if (file)
+	{
+		close();
+	}
+}
+
+void BinaryTraceWriter::write(uint64_t addr, TransactionType transType, uint64_t cycle, const uint64_t *data)
+{
+	BinaryTraceRecord record;
+	memset(&record, 0, sizeof(record));
+	record.addr = addr;
+	record.cycle = cycle;
+	record.transType = transType;
+	record.hasData = data != NULL;
+
+	bool ok = fwrite(&record, sizeof(record), 1, file) == 1;
+	if (header.flags & BINARY_TRACE_HAS_DATA)
+	{
+		uint64_t words[BINARY_TRACE_DATA_WORDS] = {0};
+		if (data)
+		{
+			memcpy(words, data, sizeof(words));
+		}
+		ok = ok && fwrite(words, sizeof(words), 1, file) == 1;
+	}
+	if (!ok)
+	{
+		ERROR("Cannot write to '"<<fileName<<"'");
+		exit(-1);
+	}
+	header.numRecords++;
+}
+
+void BinaryTraceWriter::close()
+{
+	if (fseek(file, 0, SEEK_SET) != 0 ||
+	        fwrite(&header, sizeof(header), 1, file) != 1 ||
+	        fclose(file) != 0)
+	{
+		ERROR("Cannot write to '"<<fileName<<"'");
+		exit(-1);
+	}
+	file = NULL;
+}
+
+istream *openTraceFile(const string &traceFileName)
+{
+	unsigned char magic[4] = {0};
+	FILE *file = fopen(traceFileName.c_str(), "rb");
+	if (!file)
+	{
+		return NULL;
+	}
+	size_t magicLength = fread(magic, 1, sizeof(magic), file);
+	fclose(file);
+
+	if (magicLength >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+	{
+		return new CompressedTraceStream(traceFileName, gzip);
+	}
+	if (magicLength == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+	{
+#ifndef HAVE_ZSTD
+		ERROR("'"<<traceFileName<<"' is zstd compressed, but this binary was built without zstd support (make ZSTD=1)");
+		exit(-1);
+#endif
+		return new CompressedTraceStream(traceFileName, zstd);
+	}
+	ifstream *traceFile = new ifstream(traceFileName.c_str());
+	if (!traceFile->is_open())
+	{
+		delete traceFile;
+		return NULL;
+	}
+	return traceFile;
+}
+
+DecompressingStreamBuf::DecompressingStreamBuf(const string &traceFileName, CompressionType type_) :
+	fileName(traceFileName),
+	type(type_),
+	blocks(TRACE_RING_BLOCKS),
+	blockLength(TRACE_RING_BLOCKS, 0),
+	head(0),
+	count(0),
+	holdingHead(false),
+	finished(false),
+	stopping(false)
+{
+	for (size_t i=0; i<blocks.size(); i++)
+	{
+		blocks[i] = new char[TRACE_BLOCK_SIZE];
+	}
+	pthread_mutex_init(&lock, NULL);
+	pthread_cond_init(&blockFull, NULL);
+	pthread_cond_init(&blockFree, NULL);
+	if (pthread_create(&thread, NULL, decompressMain, this) != 0)
+	{
+		ERROR("Cannot create decompression thread");
+		abort();
+	}
+}
+
+DecompressingStreamBuf::~DecompressingStreamBuf()
+{
+	pthread_mutex_lock(&lock);
+	stopping = true;
+	pthread_cond_signal(&blockFree);
+	pthread_mutex_unlock(&lock);
+	pthread_join(thread, NULL);
+
+	pthread_cond_destroy(&blockFree);
+	pthread_cond_destroy(&blockFull);
+	pthread_mutex_destroy(&lock);
+	for (size_t i=0; i<blocks.size(); i++)
+	{
+		delete [] blocks[i];
+	}
+}
+
+DecompressingStreamBuf::int_type DecompressingStreamBuf::underflow()
+{
+	pthread_mutex_lock(&lock);
+	//done with the current block, so hand it back to the decompressor
+	if (holdingHead)
+	{
+		holdingHead = false;
+		head = (head + 1) % blocks.size();
+		count--;
+		pthread_cond_signal(&blockFree);
+	}
+	while (count == 0 && !finished)
+	{
+		pthread_cond_wait(&blockFull, &lock);
+	}
+	if (count == 0)
+	{
+		pthread_mutex_unlock(&lock);
+		return traits_type::eof();
+	}
+	holdingHead = true;
+	char *block = blocks[head];
+	size_t length = blockLength[head];
+	pthread_mutex_unlock(&lock);
+
+	setg(block, block, block + length);
+	return traits_type::to_int_type(*gptr());
+}
+
+void *DecompressingStreamBuf::decompressMain(void *arg)
+{
+	DecompressingStreamBuf *self = (DecompressingStreamBuf *)arg;
+	if (self->type == gzip)
+	{
+		self->decompressGzip();
+	}
+	else
+	{
+		self->decompressZstd();
+	}
+
+	pthread_mutex_lock(&self->lock);
+	self->finished = true;
+	pthread_cond_signal(&self->blockFull);
+	pthread_mutex_unlock(&self->lock);
+	return NULL;
+}
+
+void DecompressingStreamBuf::decompressGzip()
+{
+	gzFile gz = gzopen(fileName.c_str(), "rb");
+	if (!gz)
+	{
+		ERROR("Cannot open '"<<fileName<<"'");
+		exit(-1);
+	}
+	gzbuffer(gz, 256*1024);
+
+	char *block;
+	while ((block = getFreeBlock()) != NULL)
+	{
+		int length = gzread(gz, block, TRACE_BLOCK_SIZE);
+		if (length < 0)
+		{
+			int errnum;
+			ERROR("Cannot decompress '"<<fileName<<"': "<<gzerror(gz, &errnum));
+			exit(-1);
+		}
+		if (length == 0)
+		{
+			break;
+		}
+		putFullBlock(length);
+	}
+	gzclose(gz);
+}
+
+void DecompressingStreamBuf::decompressZstd()
+{
+#ifdef HAVE_ZSTD
+	FILE *file = fopen(fileName.c_str(), "rb");
+	if (!file)
+	{
+		ERROR("Cannot open '"<<fileName<<"'");
+		exit(-1);
+	}
+	ZSTD_DStream *stream = ZSTD_createDStream();
+	ZSTD_initDStream(stream);
+
+	vector<char> inBuffer(ZSTD_DStreamInSize());
+	ZSTD_inBuffer in = {&inBuffer[0], 0, 0};
+	char *block;
+	bool inputDone = false;
+	while (!inputDone && (block = getFreeBlock()) != NULL)
+	{
+		ZSTD_outBuffer out = {block, TRACE_BLOCK_SIZE, 0};
+		while (out.pos < out.size)
+		{
+			if (in.pos == in.size)
+			{
+				in.size = fread(&inBuffer[0], 1, inBuffer.size(), file);
+				in.pos = 0;
+				if (in.size == 0)
+				{
+					inputDone = true;
+					break;
+				}
+			}
+			size_t ret = ZSTD_decompressStream(stream, &out, &in);
+			if (ZSTD_isError(ret))
+			{
+				ERROR("Cannot decompress '"<<fileName<<"': "<<ZSTD_getErrorName(ret));
+				exit(-1);
+			}
+		}
+		if (out.pos > 0)
+		{
+			putFullBlock(out.pos);
+		}
+	}
+	ZSTD_freeDStream(stream);
+	fclose(file);
+#endif
+}
+
+char *DecompressingStreamBuf::getFreeBlock()
+{
+	pthread_mutex_lock(&lock);
+	while (count == blocks.size() && !stopping)
+	{
+		pthread_cond_wait(&blockFree, &lock);
+	}
+	char *block = stopping ? NULL : blocks[(head + count) % blocks.size()];
+	pthread_mutex_unlock(&lock);
+	return block;
+}
+
+void DecompressingStreamBuf::putFullBlock(size_t length)
+{
+	pthread_mutex_lock(&lock);
+	blockLength[(head + count) % blocks.size()] = length;
+	count++;
+	pthread_cond_signal(&blockFull);
+	pthread_mutex_unlock(&lock);
+}
+
+CompressedTraceStream::CompressedTraceStream(const string &traceFileName, CompressionType type) :
+	istream(NULL),
+	buffer(traceFileName, type)
+{
+	rdbuf(&buffer);
+}
+
+TraceIngestThread::TraceIngestThread(istream *traceFile_, BinaryTraceReader *binaryTrace_, TraceType type_, bool useClockCycle_) :
+	type(type_),
+	useClockCycle(useClockCycle_),
+	traceFile(traceFile_),
+	binaryTrace(binaryTrace_),
+	ring(TRACE_INGEST_QUEUE_SIZE),
+	atEnd(binaryTrace_ ? binaryTrace_->eof() : false),
+	stopping(false),
+	head(0),
+	tail(0)
+{
+	if (pthread_create(&thread, NULL, ingestMain, this) != 0)
+	{
+		ERROR("Cannot create trace ingest thread");
+		abort();
+	}
+}
+
+TraceIngestThread::~TraceIngestThread()
+{
+	__atomic_store_n(&stopping, true, __ATOMIC_RELEASE);
+	pthread_join(thread, NULL);
+
+	//whatever was parsed but never simulated
+	for (uint64_t i=head; i<tail; i++)
+	{
+		delete ring[i % TRACE_INGEST_QUEUE_SIZE].trans;
+	}
+}
+
+TraceIngestThread::Entry TraceIngestThread::next()
+{
+	while (__atomic_load_n(&tail, __ATOMIC_ACQUIRE) == head)
+	{
+		sched_yield();
+	}
+	Entry entry = ring[head % TRACE_INGEST_QUEUE_SIZE];
+	__atomic_store_n(&head, head + 1, __ATOMIC_RELEASE);
+	atEnd = entry.last;
+	return entry;
+}
+
+bool TraceIngestThread::push(const Entry &entry)
+{
+	while (tail - __atomic_load_n(&head, __ATOMIC_ACQUIRE) == TRACE_INGEST_QUEUE_SIZE)
+	{
+		if (__atomic_load_n(&stopping, __ATOMIC_ACQUIRE))
+		{
+			return false;
+		}
+		sched_yield();
+	}
+	ring[tail % TRACE_INGEST_QUEUE_SIZE] = entry;
+	__atomic_store_n(&tail, tail + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+void *TraceIngestThread::ingestMain(void *arg)
+{
+	TraceIngestThread *self = (TraceIngestThread *)arg;
+	if (self->binaryTrace)
+	{
+		self->ingestBinary();
+	}
+	else
+	{
+		self->ingestText();
+	}
+	return NULL;
+}
+
+//one entry per getline(), blank lines included, so the simulation loop sees
+//the trace exactly as if it were reading the file itself
+void TraceIngestThread::ingestText()
+{
+	string line;
+	uint64_t addr = 0;
+	uint64_t clockCycle = 0;
+	enum TransactionType transType = DATA_READ;
+	Entry entry;
+	do
+	{
+		getline(*traceFile, line);
+		entry.trans = NULL;
+		if (line.size() > 0)
+		{
+			void *data = parseTraceFileLine(line.data(), line.size(), addr, transType, clockCycle, type, useClockCycle, false);
+			entry.trans = new Transaction(transType, addr, data);
+		}
+		entry.clockCycle = clockCycle;
+		entry.last = traceFile->eof();
+		if (!push(entry))
+		{
+			delete entry.trans;
+			return;
+		}
+	}
+	while (!entry.last);
+}
+
+void TraceIngestThread::ingestBinary()
+{
+	uint64_t clockCycle = 0;
+	while (!binaryTrace->eof())
+	{
+		const BinaryTraceRecord &record = binaryTrace->next();
+		Entry entry;
+		entry.trans = new Transaction((TransactionType)record.transType, record.addr, binaryTrace->getData(record));
+		if (useClockCycle)
+		{
+			clockCycle = record.cycle;
+		}
+		entry.clockCycle = clockCycle;
+		entry.last = binaryTrace->eof();
+		if (!push(entry))
+		{
+			delete entry.trans;
+			return;
+		}
+	}
+}
+
+} // namespace DRAMSim
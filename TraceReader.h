@@ -0,0 +1,241 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef TRACEREADER_H
+#define TRACEREADER_H
+
+//TraceReader.h
+//
+//Parsing of the text and binary trace files used by the trace based front ends
+//
+
+#include <string>
+#include <istream>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "SystemConfiguration.h"
+#include "Transaction.h"
+
+namespace DRAMSim
+{
+TraceType getTraceType(const std::string &traceFileName);
+void *parseTraceFileLine(std::string &line, uint64_t &addr, enum TransactionType &transType, uint64_t &clockCycle, TraceType type, bool useClockCycle);
+//verbose is whether the line may be echoed as it's parsed, which only the
+//simulation's own thread should do
+void *parseTraceFileLine(const char *line, size_t length, uint64_t &addr, enum TransactionType &transType, uint64_t &clockCycle, TraceType type, bool useClockCycle, bool verbose);
+void alignTransactionAddress(Transaction &trans, const Config &config);
+//opens a text trace, decompressing gzip (or zstd, when built with ZSTD=1)
+//traces on the fly; returns NULL if the file can't be opened
+std::istream *openTraceFile(const std::string &traceFileName);
+
+//binary traces are a BinaryTraceHeader followed by numRecords fixed size
+//records in host byte order; if the header has BINARY_TRACE_HAS_DATA set,
+//every record is followed by BINARY_TRACE_DATA_WORDS words of write data
+#define BINARY_TRACE_MAGIC "DRAMTRC"
+#define BINARY_TRACE_VERSION 1
+#define BINARY_TRACE_HAS_DATA 0x1
+#define BINARY_TRACE_DATA_WORDS 4
+
+struct BinaryTraceHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t flags;
+	uint64_t numRecords;
+};
+
+struct BinaryTraceRecord
+{
+	uint64_t addr;
+	uint64_t cycle;
+	uint32_t transType;
+	//nonzero if the data words following this record are valid
+	uint32_t hasData;
+};
+
+//walks the records of a binary trace straight out of an mmap()ed file
+class BinaryTraceReader
+{
+public:
+	BinaryTraceReader(const std::string &traceFileName);
+	~BinaryTraceReader();
+
+	bool eof() const
+	{
+		return cursor == end;
+	}
+	//the record is only valid as long as the reader is; a record that isn't a
+	//read or a write ends the program
+	const BinaryTraceRecord &next();
+	//copy of a record's write data for a Transaction to own (NULL if none)
+	void *getData(const BinaryTraceRecord &record) const;
+	uint64_t numRecords() const
+	{
+		return header->numRecords;
+	}
+
+	static bool isBinaryTrace(const std::string &traceFileName);
+private:
+	std::string fileName;
+	int fd;
+	char *mapping;
+	size_t mappingSize;
+	const BinaryTraceHeader *header;
+	const char *cursor;
+	const char *end;
+	size_t recordSize;
+};
+
+class BinaryTraceWriter
+{
+public:
+	BinaryTraceWriter(const std::string &traceFileName, bool withData);
+	~BinaryTraceWriter();
+	void write(uint64_t addr, TransactionType transType, uint64_t cycle, const uint64_t *data);
+	//fills in the record count; no more records can be written afterwards
+	void close();
+private:
+	FILE *file;
+	std::string fileName;
+	BinaryTraceHeader header;
+};
+
+enum CompressionType
+{
+	gzip,
+	zstd
+};
+
+//size and number of the decompressed blocks between the two threads
+#define TRACE_BLOCK_SIZE (1<<20)
+#define TRACE_RING_BLOCKS 8
+
+//a background thread decompresses the trace into a bounded ring of blocks
+//which the simulator's thread reads through the usual istream interface
+class DecompressingStreamBuf : public std::streambuf
+{
+public:
+	DecompressingStreamBuf(const std::string &traceFileName, CompressionType type);
+	~DecompressingStreamBuf();
+protected:
+	virtual int_type underflow();
+private:
+	static void *decompressMain(void *arg);
+	void decompressGzip();
+	void decompressZstd();
+	//producer side of the ring; getFreeBlock() returns NULL once the
+	//reader has gone away
+	char *getFreeBlock();
+	void putFullBlock(size_t length);
+
+	std::string fileName;
+	CompressionType type;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t blockFull;
+	pthread_cond_t blockFree;
+	std::vector<char *> blocks;
+	std::vector<size_t> blockLength;
+	//blocks[head] through blocks[head+count-1] (mod TRACE_RING_BLOCKS) hold
+	//data; the reader is still using blocks[head] while holdingHead is set
+	size_t head;
+	size_t count;
+	bool holdingHead;
+	bool finished;
+	bool stopping;
+};
+
+class CompressedTraceStream : public std::istream
+{
+public:
+	CompressedTraceStream(const std::string &traceFileName, CompressionType type);
+private:
+	DecompressingStreamBuf buffer;
+};
+
+//number of parsed transactions the ingest thread may run ahead (a power of 2)
+#define TRACE_INGEST_QUEUE_SIZE 4096
+
+//reads and parses a trace on its own thread, handing the transactions to the
+//simulation loop through a lock-free single producer/single consumer ring
+class TraceIngestThread
+{
+public:
+	struct Entry
+	{
+		//NULL for a blank line in a text trace
+		Transaction *trans;
+		uint64_t clockCycle;
+		//this is the last entry of the trace
+		bool last;
+	};
+
+	//reads from whichever of traceFile or binaryTrace isn't NULL; both have
+	//to outlive the ingest thread
+	TraceIngestThread(std::istream *traceFile, BinaryTraceReader *binaryTrace, TraceType type, bool useClockCycle);
+	~TraceIngestThread();
+
+	//true once the last entry has been handed out
+	bool eof() const
+	{
+		return atEnd;
+	}
+	//waits for the next entry if the ingest thread hasn't caught up
+	Entry next();
+private:
+	static void *ingestMain(void *arg);
+	void ingestText();
+	void ingestBinary();
+	//false if the reader has gone away
+	bool push(const Entry &entry);
+
+	TraceType type;
+	bool useClockCycle;
+	std::istream *traceFile;
+	BinaryTraceReader *binaryTrace;
+	pthread_t thread;
+	std::vector<Entry> ring;
+	bool atEnd;
+	bool stopping;
+
+	//head is only written by the simulation thread and tail only by the
+	//ingest thread; keep them on separate cache lines
+	char pad0[64];
+	uint64_t head;
+	char pad1[64];
+	uint64_t tail;
+	char pad2[64];
+};
+}
+
+#endif
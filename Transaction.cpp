@@ -36,6 +36,7 @@
 
 #include "Transaction.h"
 #include "PrintMacros.h"
+#include "AddressMapping.h"
 
 using std::endl;
 using std::hex; 
@@ -46,7 +47,12 @@ namespace DRAMSim {
 Transaction::Transaction(TransactionType transType, uint64_t addr, void *dat) :
 	transactionType(transType),
 	address(addr),
-	data(dat)
+	data(dat),
+	channel(0),
+	rank(0),
+	bank(0),
+	row(0),
+	column(0)
 {}
 
 Transaction::Transaction(const Transaction &t)
@@ -55,6 +61,11 @@ Transaction::Transaction(const Transaction &t)
 	  , data(NULL)
 	  , timeAdded(t.timeAdded)
 	  , timeReturned(t.timeReturned)
+	  , channel(t.channel)
+	  , rank(t.rank)
+	  , bank(t.bank)
+	  , row(t.row)
+	  , column(t.column)
 {
 	#ifndef NO_STORAGE
 	ERROR("Data storage is really outdated and these copies happen in an \n improper way, which will eventually cause problems. Please send an \n email to dramninjas [at] gmail [dot] com if you need data storage");
@@ -62,6 +73,11 @@ Transaction::Transaction(const Transaction &t)
 	#endif
 }
 
+void Transaction::mapAddress(const Config &config)
+{
+	addressMapping(config, address, channel, rank, bank, row, column);
+}
+
 ostream &operator<<(ostream &os, const Transaction &t)
 {
 	if (t.transactionType == DATA_READ)
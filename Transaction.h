@@ -37,6 +37,7 @@
 
 #include "SystemConfiguration.h"
 #include "BusPacket.h"
+#include "ObjectPool.h"
 
 using std::ostream; 
 
@@ -59,14 +60,40 @@ public:
 	void *data;
 	uint64_t timeAdded;
 	uint64_t timeReturned;
+	//where the address maps to, filled in once by mapAddress() when the
+	//transaction enters the memory system
+	unsigned channel;
+	unsigned rank;
+	unsigned bank;
+	unsigned row;
+	unsigned column;
 
 
 	friend ostream &operator<<(ostream &os, const Transaction &t);
 	//functions
 	Transaction(TransactionType transType, uint64_t addr, void *data);
 	Transaction(const Transaction &t);
+	void mapAddress(const Config &config);
 
-	BusPacketType getBusPacketType()
+	static void *operator new(size_t size)
+	{
+		return ObjectPool<Transaction>::allocate(size);
+	}
+	//the memory system counts the ones it creates itself in its stats
+	static void *operator new(size_t size, PoolStats &stats)
+	{
+		return ObjectPool<Transaction>::allocate(size, &stats);
+	}
+	static void operator delete(void *p)
+	{
+		ObjectPool<Transaction>::release(p);
+	}
+	static void operator delete(void *p, PoolStats &)
+	{
+		ObjectPool<Transaction>::release(p);
+	}
+
+	BusPacketType getBusPacketType(RowBufferPolicy rowBufferPolicy)
 	{
 		switch (transactionType)
 		{
@@ -75,7 +102,7 @@ public:
 			{
 				return READ_P;
 			}
-			else if (rowBufferPolicy == OpenPage)
+			else if (rowBufferPolicy == OpenPage || rowBufferPolicy == AdaptivePage)
 			{
 				return READ; 
 			}
@@ -90,7 +117,7 @@ public:
 			{
 				return WRITE_P;
 			}
-			else if (rowBufferPolicy == OpenPage)
+			else if (rowBufferPolicy == OpenPage || rowBufferPolicy == AdaptivePage)
 			{
 				return WRITE; 
 			}
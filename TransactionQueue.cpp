@@ -0,0 +1,401 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//TransactionQueue.cpp
+//
+//Class file for the memory controller's queue of incoming transactions
+//
+
+#include "TransactionQueue.h"
+#include "AddressMapping.h"
+#include <algorithm>
+#include <assert.h>
+
+using namespace DRAMSim;
+
+TransactionQueue::TransactionQueue(const Config &config_) :
+	config(config_),
+	count(0),
+	nextAge(0),
+	bankLists(config_.NUM_RANKS*config_.NUM_BANKS*2),
+	occupiedBanks((config_.NUM_RANKS*config_.NUM_BANKS+63)/64, 0),
+	scheduledRows(config_.NUM_RANKS, vector<unsigned>(config_.NUM_BANKS, -1)),
+	oldestBypassed(0),
+	writeCount(0),
+	drainingWrites(false),
+	filterByType(false),
+	wantedType(DATA_READ),
+	writeDrains(0)
+{
+}
+
+TransactionQueue::~TransactionQueue()
+{
+	for (size_t i=0;i<bankLists.size();i++)
+	{
+		for (Node *node = bankLists[i].head; node; node = node->next[BANK_LIST])
+		{
+			delete node->entry.trans;
+		}
+	}
+	for (size_t i=0;i<allNodes.size();i++)
+	{
+		delete allNodes[i];
+	}
+}
+
+void TransactionQueue::append(NodeList &list, Node *node, unsigned which)
+{
+	node->prev[which] = list.tail;
+	node->next[which] = NULL;
+	if (list.tail)
+	{
+		list.tail->next[which] = node;
+	}
+	else
+	{
+		list.head = node;
+	}
+	list.tail = node;
+}
+
+void TransactionQueue::unlink(NodeList &list, Node *node, unsigned which)
+{
+	if (node->prev[which])
+	{
+		node->prev[which]->next[which] = node->next[which];
+	}
+	else
+	{
+		list.head = node->next[which];
+	}
+	if (node->next[which])
+	{
+		node->next[which]->prev[which] = node->prev[which];
+	}
+	else
+	{
+		list.tail = node->prev[which];
+	}
+}
+
+#ifdef DEBUG_CHECKS
+//every way into the memory system has to map the transaction before it gets
+//here; a transaction that skipped it would silently land in rank 0, bank 0
+bool TransactionQueue::isMapped(const Transaction *trans) const
+{
+	unsigned chan, rank, bank, row, col;
+	addressMapping(config, trans->address, chan, rank, bank, row, col);
+	return trans->rank == rank && trans->bank == bank && trans->row == row && trans->column == col;
+}
+#endif
+
+//the transaction has already been mapped, so it goes straight onto its lists
+void TransactionQueue::push(Transaction *trans)
+{
+#ifdef DEBUG_CHECKS
+	assert(isMapped(trans));
+#endif
+	Node *node;
+	if (freeNodes.empty())
+	{
+		node = new Node();
+		allNodes.push_back(node);
+	}
+	else
+	{
+		node = freeNodes.back();
+		freeNodes.pop_back();
+	}
+	node->entry.trans = trans;
+	node->entry.age = nextAge++;
+
+	unsigned bank = bankIndex(trans);
+	bool isWrite = trans->transactionType == DATA_WRITE;
+	append(bankLists[bank*2 + isWrite], node, BANK_LIST);
+	node->rowList = &rowLists[rowKey(bank, trans->row, isWrite)];
+	append(*node->rowList, node, ROW_LIST);
+	node->addressList = &addressLists[trans->address];
+	append(*node->addressList, node, ADDRESS_LIST);
+	occupiedBanks[bank/64] |= 1ULL << (bank%64);
+
+	count++;
+	if (isWrite)
+	{
+		writeCount++;
+	}
+}
+
+//takes a node off all its lists (forgetting the lists that are now empty)
+void TransactionQueue::remove(Node *n)
+{
+	const Transaction *trans = n->entry.trans;
+	unsigned bank = bankIndex(trans);
+	bool isWrite = trans->transactionType == DATA_WRITE;
+
+	unlink(bankLists[bank*2 + isWrite], n, BANK_LIST);
+	unlink(*n->rowList, n, ROW_LIST);
+	if (!n->rowList->head)
+	{
+		rowLists.erase(rowKey(bank, trans->row, isWrite));
+	}
+	unlink(*n->addressList, n, ADDRESS_LIST);
+	if (!n->addressList->head)
+	{
+		addressLists.erase(trans->address);
+	}
+	if (!bankLists[bank*2].head && !bankLists[bank*2 + 1].head)
+	{
+		occupiedBanks[bank/64] &= ~(1ULL << (bank%64));
+	}
+
+	freeNodes.push_back(n);
+	count--;
+}
+
+bool TransactionQueue::pop(CommandQueue &commandQueue, Entry &entry)
+{
+	//with write draining, reads go first until the writes pile up to the high
+	//	watermark, then only writes go until they are down to the low one
+	if (config.WRITE_HIGH_WATERMARK > 0)
+	{
+		if (!drainingWrites && writeCount >= config.WRITE_HIGH_WATERMARK)
+		{
+			drainingWrites = true;
+			writeDrains++;
+		}
+		else if (drainingWrites && writeCount <= config.WRITE_LOW_WATERMARK)
+		{
+			drainingWrites = false;
+		}
+		//writes can still go when there are no reads waiting
+		filterByType = drainingWrites || writeCount < count;
+		wantedType = drainingWrites ? DATA_WRITE : DATA_READ;
+	}
+
+	bool popped;
+	if (config.schedulingPolicy == FRFCFS)
+	{
+		popped = popRowHitFirst(commandQueue, entry);
+	}
+	else
+	{
+		popped = popOldestSchedulable(commandQueue, entry);
+	}
+	if (popped && entry.trans->transactionType == DATA_WRITE)
+	{
+		writeCount--;
+	}
+	return popped;
+}
+
+bool TransactionQueue::hasSchedulable(CommandQueue &commandQueue) const
+{
+	for (size_t w=0;w<occupiedBanks.size();w++)
+	{
+		for (uint64_t bits = occupiedBanks[w]; bits; bits &= bits-1)
+		{
+			unsigned bank = w*64 + __builtin_ctzll(bits);
+			if (nextEligible(bank, -1) && commandQueue.hasRoomFor(2, bank/config.NUM_BANKS, bank%config.NUM_BANKS))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/*
+ * Returns the first transaction in a bank that may be scheduled now (and goes
+ * to row, unless row is -1), or NULL if there is none. Reads and writes to the
+ * same address have to stay in order, so if anything older goes to the same
+ * address, that goes first.
+ */
+TransactionQueue::Node *TransactionQueue::nextEligible(unsigned bank, unsigned row) const
+{
+	Node *reads, *writes;
+	if (row == (unsigned)-1)
+	{
+		reads = bankLists[bank*2].head;
+		writes = bankLists[bank*2 + 1].head;
+	}
+	else
+	{
+		NodeListMap::const_iterator it;
+		it = rowLists.find(rowKey(bank, row, false));
+		reads = it == rowLists.end() ? NULL : it->second.head;
+		it = rowLists.find(rowKey(bank, row, true));
+		writes = it == rowLists.end() ? NULL : it->second.head;
+	}
+
+	Node *node;
+	if (filterByType)
+	{
+		node = wantedType == DATA_WRITE ? writes : reads;
+	}
+	else if (reads && writes)
+	{
+		node = reads->entry.age < writes->entry.age ? reads : writes;
+	}
+	else
+	{
+		node = reads ? reads : writes;
+	}
+	//the oldest transaction to an address is at the head of its list
+	return node ? node->addressList->head : NULL;
+}
+
+/*
+ * Removes the oldest transaction whose commands (an activate and a read or
+ * write) fit into the command queue. Only the first transaction in each bank
+ * that may go needs to be compared, since everything behind it is younger and
+ * goes to the same bank. Returns false if none of them fit.
+ */
+bool TransactionQueue::popOldestSchedulable(CommandQueue &commandQueue, Entry &entry)
+{
+	Node *oldest = NULL;
+	for (size_t w=0;w<occupiedBanks.size();w++)
+	{
+		for (uint64_t bits = occupiedBanks[w]; bits; bits &= bits-1)
+		{
+			unsigned bank = w*64 + __builtin_ctzll(bits);
+			Node *node = nextEligible(bank, -1);
+			if (!node || (oldest && oldest->entry.age < node->entry.age))
+			{
+				continue;
+			}
+			if (commandQueue.hasRoomFor(2, bank/config.NUM_BANKS, bank%config.NUM_BANKS))
+			{
+				oldest = node;
+			}
+		}
+	}
+
+	if (!oldest)
+	{
+		return false;
+	}
+	entry = oldest->entry;
+	remove(oldest);
+	return true;
+}
+
+/*
+ * FR-FCFS: removes the oldest transaction to a row that its bank has open (or
+ * will have open once the commands already queued for it have gone), and only
+ * if there is none the oldest transaction overall. Only transactions whose
+ * commands fit into the command queue are considered. To keep row hits from
+ * starving everything else, at most TOTAL_ROW_ACCESSES of them are taken
+ * ahead of the oldest transaction.
+ */
+bool TransactionQueue::popRowHitFirst(CommandQueue &commandQueue, Entry &entry)
+{
+	Node *oldest = NULL;
+	Node *hit = NULL;
+	for (size_t w=0;w<occupiedBanks.size();w++)
+	{
+		for (uint64_t bits = occupiedBanks[w]; bits; bits &= bits-1)
+		{
+			unsigned bank = w*64 + __builtin_ctzll(bits);
+			unsigned rank = bank/config.NUM_BANKS;
+			Node *node = nextEligible(bank, -1);
+			if (!node || !commandQueue.hasRoomFor(2, rank, bank%config.NUM_BANKS))
+			{
+				continue;
+			}
+			if (!oldest || node->entry.age < oldest->entry.age)
+			{
+				oldest = node;
+			}
+
+			//the bank's oldest hit; anything older to the same address goes to
+			//	the same row, so it is a hit as well
+			unsigned row = scheduledRows[rank][bank%config.NUM_BANKS];
+			if (row == (unsigned)-1)
+			{
+				continue;
+			}
+			node = nextEligible(bank, row);
+			if (node && (!hit || node->entry.age < hit->entry.age))
+			{
+				hit = node;
+			}
+		}
+	}
+
+	if (!oldest)
+	{
+		return false;
+	}
+
+	if (hit && oldestBypassed < config.TOTAL_ROW_ACCESSES && hit != oldest)
+	{
+		entry = hit->entry;
+		remove(hit);
+		oldestBypassed++;
+	}
+	else
+	{
+		entry = oldest->entry;
+		remove(oldest);
+		oldestBypassed = 0;
+	}
+	scheduledRows[entry.trans->rank][entry.trans->bank] = entry.trans->row;
+	return true;
+}
+
+void TransactionQueue::rowClosed(unsigned rank, unsigned bank, unsigned row)
+{
+	//if another row has been scheduled since, that's the one that will be open next
+	if (scheduledRows[rank][bank] == row)
+	{
+		scheduledRows[rank][bank] = -1;
+	}
+}
+
+static bool olderThan(const TransactionQueue::Entry &a, const TransactionQueue::Entry &b)
+{
+	return a.age < b.age;
+}
+
+vector<TransactionQueue::Entry> TransactionQueue::getAll() const
+{
+	vector<Entry> all;
+	all.reserve(count);
+	for (size_t i=0;i<bankLists.size();i++)
+	{
+		for (const Node *node = bankLists[i].head; node; node = node->next[BANK_LIST])
+		{
+			all.push_back(node->entry);
+		}
+	}
+	sort(all.begin(), all.end(), olderThan);
+	return all;
+}
@@ -0,0 +1,166 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef TRANSACTIONQUEUE_H
+#define TRANSACTIONQUEUE_H
+
+//TransactionQueue.h
+//
+//Header file for the memory controller's queue of incoming transactions
+//
+
+#include "Transaction.h"
+#include "SystemConfiguration.h"
+#include "CommandQueue.h"
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+namespace DRAMSim
+{
+//every transaction is stamped with the order it arrived in and kept in FIFOs
+//per bank and type, per row and per address, so the transaction a bank may
+//schedule next is always at the head of one of them and can be unlinked from
+//all of them in constant time
+class TransactionQueue
+{
+public:
+	struct Entry
+	{
+		Transaction *trans;
+		uint64_t age;
+	};
+
+	TransactionQueue(const Config &config_);
+	~TransactionQueue();
+
+	void push(Transaction *trans);
+	//removes the next transaction to schedule according to SCHEDULING_POLICY
+	bool pop(CommandQueue &commandQueue, Entry &entry);
+	bool popOldestSchedulable(CommandQueue &commandQueue, Entry &entry);
+	bool popRowHitFirst(CommandQueue &commandQueue, Entry &entry);
+	//whether pop() would find a transaction
+	bool hasSchedulable(CommandQueue &commandQueue) const;
+	//tells FR-FCFS that a row has been closed, so requests to it are no longer hits
+	void rowClosed(unsigned rank, unsigned bank, unsigned row);
+	size_t size() const
+	{
+		return count;
+	}
+	bool empty() const
+	{
+		return count == 0;
+	}
+	//every transaction, oldest first
+	vector<Entry> getAll() const;
+	//how many times the write watermark has been reached since the last reset
+	uint64_t getWriteDrains() const
+	{
+		return writeDrains;
+	}
+	void resetStats()
+	{
+		writeDrains = 0;
+	}
+
+private:
+	//the lists a queued transaction is on
+	enum
+	{
+		BANK_LIST, // its bank's transactions of its type
+		ROW_LIST, // its bank's transactions of its type to its row
+		ADDRESS_LIST, // the transactions to its address
+		NUM_LISTS
+	};
+	struct Node;
+	struct NodeList
+	{
+		Node *head;
+		Node *tail;
+		NodeList() : head(NULL), tail(NULL) {}
+	};
+	struct Node
+	{
+		Entry entry;
+		Node *prev[NUM_LISTS];
+		Node *next[NUM_LISTS];
+		NodeList *rowList;
+		NodeList *addressList;
+	};
+	typedef unordered_map<uint64_t, NodeList> NodeListMap;
+
+	const Config &config;
+	size_t count;
+	uint64_t nextAge;
+
+	//indexed by SEQUENTIAL(rank,bank)*2 + (1 for writes)
+	vector<NodeList> bankLists;
+	NodeListMap rowLists; // key from rowKey()
+	NodeListMap addressLists;
+	//one bit per SEQUENTIAL(rank,bank) that has anything queued
+	vector<uint64_t> occupiedBanks;
+	vector<Node *> freeNodes;
+	vector<Node *> allNodes;
+
+	//FR-FCFS: the row each bank has open or is about to open for the last
+	//	transaction scheduled to it (-1 if none), and how many row hits have been
+	//	scheduled ahead of the oldest transaction
+	vector< vector<unsigned> > scheduledRows;
+	unsigned oldestBypassed;
+
+	//write draining (see WRITE_HIGH_WATERMARK): when filterByType is set only
+	//	transactions of wantedType are scheduled
+	size_t writeCount;
+	bool drainingWrites;
+	bool filterByType;
+	TransactionType wantedType;
+	uint64_t writeDrains;
+
+	unsigned bankIndex(const Transaction *trans) const
+	{
+		return trans->rank*config.NUM_BANKS + trans->bank;
+	}
+	static uint64_t rowKey(unsigned bank, unsigned row, bool isWrite)
+	{
+		return ((uint64_t)bank << 33) | ((uint64_t)row << 1) | isWrite;
+	}
+	static void append(NodeList &list, Node *node, unsigned which);
+	static void unlink(NodeList &list, Node *node, unsigned which);
+	Node *nextEligible(unsigned bank, unsigned row) const;
+	void remove(Node *node);
+#ifdef DEBUG_CHECKS
+	//whether the stored coordinates are the ones the address maps to
+	bool isMapped(const Transaction *trans) const;
+#endif
+};
+}
+
+#endif